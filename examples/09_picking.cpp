@@ -87,7 +87,13 @@ public:
         }
         sceneRenderPass.finish();
 
-        auto pixelValues = sceneRenderPass.readPixels(mouseX, mouseY);           // read pixel values from framebuffer
+        if (pixelReadback && pixelReadback->isReady()){
+            pixelValue = pixelReadback->getPixels()[0];
+            pixelReadback.reset();
+        }
+        if (!pixelReadback){
+            pixelReadback = sceneRenderPass.readPixelsAsync(mouseX, mouseY);    // read pixel values from framebuffer (without stalling)
+        }
 
         // render gui to framebuffer
         auto guiRenderPass = RenderPass::create()
@@ -103,8 +109,6 @@ public:
         }
 
         guiRenderPass.finish();
-
-        pixelValue = pixelValues[0];
     }
 
     void drawTopTextAndColor(sre::Color color){
@@ -125,6 +129,7 @@ private:
     std::shared_ptr<Material> mat[4];
     std::shared_ptr<Mesh> mesh[4];
     Color pixelValue;
+    std::shared_ptr<PixelReadback> pixelReadback;
     int i=0;
     int mouseX;
     int mouseY;
@@ -7,6 +7,7 @@
 #include "sre/Texture.hpp"
 #include "sre/Renderer.hpp"
 #include "sre/Material.hpp"
+#include "sre/RenderList.hpp"
 #include "sre/SDLRenderer.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -28,8 +29,12 @@ public:
         camera = new Camera();
         camera->setPerspectiveProjection(90,0.1,100);
 
+        auto texture = Texture::create().withFile("examples_data/test.png").withGenerateMipmaps(true).build();
         material = Shader::getUnlit()->createMaterial();
-        material->setTexture(Texture::create().withFile("examples_data/test.png").withGenerateMipmaps(true).build());
+        material->setTexture(texture);
+        // the instanced material allows the render pass to draw all boxes using a single draw call
+        instancedMaterial = Shader::getUnlit()->createMaterial({{"S_INSTANCED","1"}});
+        instancedMaterial->setTexture(texture);
 
         mesh = Mesh::create().withCube(0.25f).build();
 
@@ -71,15 +76,38 @@ public:
         auto renderPass = RenderPass::create()
                 .withCamera(*camera)
                 .withClearColor(true, {0, 0, 0, 1})
+                .withDepthPrepass(depthPrepass)
+                .withOcclusionCulling(occlusionCulling)
+                .withSortMode(occlusionCulling ? SortMode::FrontToBack : SortMode::None)
                 .build();
-        for (int i = 0; i < gridSize; ++i) {
+        if (retained){
+            // static boxes are recorded once in a render list
+            if (renderList == nullptr || renderListGridSize != gridSize || renderListInstancing != instancing){
+                renderList = RenderList::create();
+                renderListGridSize = gridSize;
+                renderListInstancing = instancing;
+                for (int i = 0; i < gridSize; ++i) {
+                    for (int j = 0; j < gridSize; ++j) {
+                        for (int k = 0; k < gridSize; ++k) {
+                            auto & boxRef = box[i][j][k];
+                            modelMatrix[i][j][k] = boxRef.translationMatrix * boxRef.rotationMatrix;
+                            renderList->draw(mesh, modelMatrix[i][j][k], instancing ? instancedMaterial : material);
+                        }
+                    }
+                }
+            }
+            renderPass.draw(renderList);
+        } else {
+            renderList.reset();
+        }
+        for (int i = 0; i < gridSize && !retained; ++i) {
             for (int j = 0; j < gridSize; ++j) {
                 for (int k = 0; k < gridSize; ++k) {
                     auto & boxRef = box[i][j][k];
                     // update rotation
                     boxRef.rotationMatrix = glm::rotate(boxRef.rotationMatrix,0.02f, glm::vec3(1,1,1));
                     modelMatrix[i][j][k] = boxRef.translationMatrix * boxRef.rotationMatrix;
-                    renderPass.draw(mesh, modelMatrix[i][j][k], material);
+                    renderPass.draw(mesh, modelMatrix[i][j][k], instancing ? instancedMaterial : material);
                 }
             }
         }
@@ -91,6 +119,10 @@ public:
         }
 
         ImGui::SliderInt("Grid size",&gridSize,1,BOX_GRID_DIM);
+        ImGui::Checkbox("Instancing",&instancing);
+        ImGui::Checkbox("Static (render list)",&retained);
+        ImGui::Checkbox("Depth pre-pass",&depthPrepass);
+        ImGui::Checkbox("Occlusion culling",&occlusionCulling);
     }
 private:
     int gridSize = BOX_GRID_DIM/2;
@@ -101,6 +133,14 @@ private:
     Camera *camera;
     std::shared_ptr<Mesh> mesh;
     std::shared_ptr<Material> material;
+    std::shared_ptr<Material> instancedMaterial;
+    bool instancing = true;
+    bool retained = false;
+    bool depthPrepass = false;
+    bool occlusionCulling = false;
+    std::shared_ptr<RenderList> renderList;
+    int renderListGridSize = 0;
+    bool renderListInstancing = false;
     int i=0;
     struct Box{
         float rotate;
@@ -238,6 +238,8 @@ int CONSTRAINT_ITERATIONS = 7; // how many iterations of constraint satisfaction
                     .withUVs(getUVs())
                     .withIndices(createIndices())
                     .withMeshTopology(MeshTopology::TriangleStrip)
+                    .withUsage(MeshUsage::Stream)
+                    .withLayout(MeshLayout::Separate)       // the uvs are not uploaded again when positions and normals change
                     .build();
 
             material = Shader::getStandardPBR()->createMaterial({{"S_TWO_SIDED","true"}});
@@ -284,11 +286,9 @@ int CONSTRAINT_ITERATIONS = 7; // how many iterations of constraint satisfaction
                 }
             }
 
-            // update mesh data
-            mesh->update()
-                    .withPositions(getPositions())
-                    .withNormals(getNormals())
-                    .build();
+            // update mesh data (in place, the vertex layout and count are unchanged)
+            mesh->updateAttribute("position", getPositions());
+            mesh->updateAttribute("normal", getNormals());
 
             rp.draw(mesh,glm::mat4(1.0f), material);
         }
@@ -3,6 +3,7 @@
 #include "sre/Texture.hpp"
 #include "sre/Renderer.hpp"
 #include "sre/Material.hpp"
+#include "sre/FrameGraph.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/euler_angles.hpp>
@@ -39,33 +40,6 @@ public:
         shadowMapMat = Shader::getShadow()->createMaterial();
         mat->setName("Shadow material");
 
-        if (!sre::renderInfo().supportFBODepthAttachment){         // if not support for depth textures
-            shadowMapTexture = Texture::create()
-                    .withName("ShadowMapTex")
-                    .withGenerateMipmaps(false)
-                    .withFilterSampling(false)                     // filtering not supported, since packing depth in RGBA
-                    .withRGBAData(nullptr,shadowMapSize,shadowMapSize)
-                    .build();
-
-            shadowMap = Framebuffer::create()
-                    .withName("ShadowMap")
-                    .withColorTexture(shadowMapTexture)
-                    .build();
-        } else {
-            shadowMapTexture = Texture::create()
-                    .withName("ShadowMapTex")
-                    .withGenerateMipmaps(false)
-                    .withFilterSampling(true)
-                    .withWrapUV(Texture::Wrap::ClampToBorder)
-                    .withDepth(shadowMapSize,shadowMapSize, Texture::DepthPrecision::I24)
-                    .build();
-
-            shadowMap = Framebuffer::create()
-                    .withName("ShadowMap")
-                    .withDepthTexture(shadowMapTexture)
-                    .build();
-        }
-
         r.frameRender = [&](){
             render();
         };
@@ -107,39 +81,62 @@ public:
     }
 
     void render(){
+        // the shadow map is a transient texture of the frame graph (the texture is reused between frames)
+        FrameGraph frameGraph;
+        FrameGraph::Resource shadowMap;
+
         // shadow pass - build shadow map - render shadow casters with shadow material
-        updataShadowmapViewProjection(&shadowmapCamera, lightDirection, fieldOfViewY, near, far, eye, at);
-        auto rp = RenderPass::create()
-                .withFramebuffer(shadowMap)
-                .withCamera(shadowmapCamera)
-                .withWorldLights(&worldLights)
-                .withClearColor(true,{1,1,1,1})
-                .withGUI(false)
-                .build();
+        frameGraph.addPass("Shadow map", [&](FrameGraph::PassBuilder& builder){
+            FrameGraph::TextureDescription description;
+            description.size = glm::ivec2(shadowMapSize);
+            if (sre::renderInfo().supportFBODepthAttachment){
+                description.depth = true;
+                description.wrap = Texture::Wrap::ClampToBorder;
+            } else {                                                // if not support for depth textures
+                description.filterSampling = false;                 // filtering not supported, since packing depth in RGBA
+            }
+            shadowMap = builder.createTexture("ShadowMapTex", description);
+        }, [&](FrameGraph::PassContext& context){
+            updataShadowmapViewProjection(&shadowmapCamera, lightDirection, fieldOfViewY, near, far, eye, at);
+            auto rp = RenderPass::create()
+                    .withFramebuffer(context.getFramebuffer())
+                    .withCamera(shadowmapCamera)
+                    .withWorldLights(&worldLights)
+                    .withClearColor(true,{1,1,1,1})
+                    .withGUI(false)
+                    .build();
 
-        renderWorld(rp, shadowMapMat);
+            renderWorld(rp, shadowMapMat);
 
-        rp.finish();
+            rp.finish();
+        });
 
         // render pass - render world with shadow lookup
-        auto rp2 = RenderPass::create()
-                .withCamera(camera)
-                .withClearColor(true,{0,0,0,1})
-                .withWorldLights(&worldLights)
-                .build();
-
-        mat->set("shadowMap", shadowMapTexture);
-        static glm::mat4 offset = glm::translate(glm::vec3(0.5f)) * glm::scale(glm::vec3(0.5f));
-        glm::mat4 shadowViewProjOffset = offset * shadowmapCamera.getProjectionTransform({shadowMapSize,shadowMapSize}) * shadowmapCamera.getViewTransform();
-        mat->set("shadowViewProjOffset", shadowViewProjOffset);
-
-        renderWorld(rp2, mat);
-
-        static Inspector inspector;
-        inspector.update();
-        if (showInspector){
-            inspector.gui();
-        }
+        frameGraph.addPass("World", [&](FrameGraph::PassBuilder& builder){
+            builder.read(shadowMap);
+            builder.writeScreen();
+        }, [&](FrameGraph::PassContext& context){
+            auto rp2 = RenderPass::create()
+                    .withCamera(camera)
+                    .withClearColor(true,{0,0,0,1})
+                    .withWorldLights(&worldLights)
+                    .build();
+
+            mat->set("shadowMap", context.getTexture(shadowMap));
+            static glm::mat4 offset = glm::translate(glm::vec3(0.5f)) * glm::scale(glm::vec3(0.5f));
+            glm::mat4 shadowViewProjOffset = offset * shadowmapCamera.getProjectionTransform({shadowMapSize,shadowMapSize}) * shadowmapCamera.getViewTransform();
+            mat->set("shadowViewProjOffset", shadowViewProjOffset);
+
+            renderWorld(rp2, mat);
+
+            static Inspector inspector;
+            inspector.update();
+            if (showInspector){
+                inspector.gui();
+            }
+        });
+
+        frameGraph.execute();
     }
 private:
     float fieldOfViewY = 45;
@@ -156,8 +153,6 @@ private:
     std::shared_ptr<Mesh> meshPlane;
     std::shared_ptr<Material> mat;
     std::shared_ptr<Material> shadowMapMat;
-    std::shared_ptr<Framebuffer> shadowMap;
-    std::shared_ptr<Texture> shadowMapTexture;
     float rotateX = 0;
     float rotateY = 0;
     int texture = 0;
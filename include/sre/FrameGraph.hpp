@@ -0,0 +1,120 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include "sre/Texture.hpp"
+#include "sre/impl/Export.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sre {
+    class Framebuffer;
+
+    /**
+     * A frame graph describes the render passes of a frame and the textures they read and write.
+     *
+     * A pass is added using a setup function, which declares the textures of the pass (using PassBuilder), and an
+     * execute function, which renders the pass (typically creating a RenderPass using PassContext::getFramebuffer()).
+     * When the graph is executed it:
+     * - orders the passes, such that a pass runs after the passes writing the textures it reads
+     * - culls passes whose outputs are never read (passes writing to the screen or to imported textures are kept)
+     * - allocates transient textures from a pool, where resources with non-overlapping lifetimes share a texture
+     * - invalidates transient textures after their last use (glInvalidateFramebuffer)
+     *
+     * The graph is built and executed each frame. The transient textures are kept by the Renderer between frames
+     * (and released when unused for a few frames).
+     */
+    class DllExport FrameGraph {
+    public:
+        using Resource = int;                                               // handle of a texture in the graph
+
+        struct DllExport TextureDescription {
+            glm::ivec2 size;
+            bool depth = false;                                             // depth texture (otherwise RGBA)
+            Texture::DepthPrecision depthPrecision = Texture::DepthPrecision::I24;
+            bool filterSampling = true;
+            Texture::Wrap wrap = Texture::Wrap::ClampToEdge;
+
+            bool operator==(const TextureDescription& other) const;
+        };
+
+        class DllExport PassBuilder {
+        public:
+            Resource createTexture(const std::string& name,                 // Create a transient texture written by the pass
+                                   const TextureDescription& description);
+            Resource read(Resource resource);                               // The pass samples the texture
+            Resource write(Resource resource);                              // The pass renders to the texture (color attachments
+                                                                            // are assigned in the order of the calls)
+            void writeScreen();                                             // The pass renders to the screen
+        private:
+            PassBuilder(FrameGraph* frameGraph, int pass);
+            FrameGraph* frameGraph;
+            int pass;
+            friend class FrameGraph;
+        };
+
+        class DllExport PassContext {
+        public:
+            std::shared_ptr<Framebuffer> getFramebuffer();                  // Framebuffer of the written textures (nullptr for the screen)
+            std::shared_ptr<Texture> getTexture(Resource resource);         // Texture of a resource read or written by the pass
+        private:
+            PassContext(FrameGraph* frameGraph, int pass, std::shared_ptr<Framebuffer> framebuffer);
+            FrameGraph* frameGraph;
+            int pass;
+            std::shared_ptr<Framebuffer> framebuffer;
+            friend class FrameGraph;
+        };
+
+        Resource importTexture(const std::string& name,                     // Use a long-lived texture in the graph (never aliased
+                               std::shared_ptr<Texture> texture);           // or invalidated)
+        void addPass(const std::string& name,                               // Add a pass. Setup is called immediately, and execute
+                     std::function<void(PassBuilder&)> setup,               // is called from FrameGraph::execute() (unless culled)
+                     std::function<void(PassContext&)> execute);
+
+        void execute();                                                     // Order, cull and execute the passes (once per graph)
+
+        std::vector<std::string> getPassOrder();                            // Names of the passes execute() runs (in execution
+                                                                            // order, culled passes excluded). Does not render.
+
+        const std::vector<std::string>& getExecutedPasses();                // Names of the executed passes (in execution order)
+    private:
+        struct ResourceNode {
+            std::string name;
+            TextureDescription description;
+            std::shared_ptr<Texture> imported;                              // nullptr for transient textures
+            std::vector<int> writers;                                       // passes (in declaration order)
+            std::vector<int> readers;
+            std::shared_ptr<Texture> texture;                               // assigned while executing
+            int firstUse = -1;                                              // position in the execution order
+            int lastUse = -1;
+            int poolIndex = -1;                                             // index in Renderer::transientTextures
+            std::shared_ptr<Framebuffer> lastFramebuffer;                   // framebuffer the texture was last attached to
+        };
+        struct PassNode {
+            std::string name;
+            std::function<void(PassContext&)> execute;
+            std::vector<Resource> reads;
+            std::vector<Resource> writes;
+            bool writesScreen = false;
+            bool culled = false;
+        };
+        std::vector<int> sortPasses();                                      // topological order of the passes
+        void cullPasses();
+        std::shared_ptr<Framebuffer> getFramebuffer(int pass);
+        void acquireTexture(ResourceNode& resource, std::vector<bool>& poolInUse);
+        void invalidate(ResourceNode& resource);
+
+        std::vector<ResourceNode> resources;
+        std::vector<PassNode> passes;
+        std::vector<std::string> executedPasses;
+        bool executed = false;
+    };
+}
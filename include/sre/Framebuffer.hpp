@@ -77,6 +77,7 @@ namespace sre {
         glm::uvec2 size;
         friend class RenderPass;
         friend class Inspector;
+        friend class FrameGraph;
     };
 }
 
@@ -63,6 +63,7 @@ namespace sre {
         std::vector<float> millisecondsEvent;
         std::vector<float> millisecondsUpdate;
         std::vector<float> millisecondsRender;
+        std::vector<float> millisecondsGpu;
         std::vector<RenderStats> stats;
 
         std::vector<float> data;
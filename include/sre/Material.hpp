@@ -97,6 +97,15 @@ namespace sre {
 
         UniformSet uniformMap;
 
+        void updateUniformBuffer();                                     // write uniformMap to the material uniform block (if changed)
+        GLuint uniformBuffer = 0;                                       // material uniform block (if declared by the shader)
+        std::vector<char> uniformBufferData;
+        bool uniformBufferDirty = true;
+        bool uniformBufferHasArrays = false;                            // arrays are shared (and may change without set())
+
+        static uint16_t materialIdCount;
+        uint16_t materialId;                                            // used for sorting draw calls
+
         friend class Shader;
         friend class RenderPass;
         friend class Inspector;
@@ -111,7 +120,7 @@ namespace sre {
         for (auto & tv : uniformMap.textureValues){
             auto res = uniformMap.textureValues.find(t.id);
             if (res != uniformMap.textureValues.end()){
-                return res->second;
+                return res->second.texture;
             }
         }
         return nullptr;
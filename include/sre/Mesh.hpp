@@ -14,6 +14,9 @@
 #include <cstdint>
 #include <map>
 #include "sre/MeshTopology.hpp"
+#include "sre/MeshUsage.hpp"
+#include "sre/MeshLayout.hpp"
+#include "sre/VertexAttributeFormat.hpp"
 
 #include "sre/impl/Export.hpp"
 #include "Shader.hpp"
@@ -25,6 +28,7 @@ namespace sre {
     class Shader;
     class Inspector;
     class RenderPass;
+    class GeometryPool;
 
     /**
      * Represents a Mesh object.
@@ -87,11 +91,31 @@ namespace sre {
             MeshBuilder& withAttribute(std::string name, const std::vector<glm::vec4> &values);   // Set a named vertex attribute of vec4
             MeshBuilder& withAttribute(std::string name, const std::vector<glm::i32vec4> &values);// Set a named vertex attribute of i32vec4. On platforms not
                                                                                                   // supporting i32vec4 the values are converted to vec4
+            MeshBuilder& withAttributeFormat(std::string name, VertexAttributeFormat format);     // Store a float vertex attribute in a compact format (e.g. half
+                                                                                                  // floats, or SNorm10_10_10_2 normals). When any format is set,
+                                                                                                  // the vertex is tightly packed (without vec4 padding). Ignored
+                                                                                                  // on OpenGL ES 2 / WebGL 1
 
             // other
             MeshBuilder& withName(const std::string& name);                                       // Defines the name of the mesh
             MeshBuilder& withRecomputeNormals(bool enabled);                                      // Recomputes normals using angle weighted normals
             MeshBuilder& withRecomputeTangents(bool enabled);                                     // Recomputes tangents using (Lengyel’s Method)
+            MeshBuilder& withGeometryPool(bool enabled = true);                                   // Store the vertices and indices in buffers shared with other
+                                                                                                  // meshes using the same vertex attributes. Avoids state
+                                                                                                  // changes between the meshes and allows RenderPass to draw
+                                                                                                  // them using a single multi draw call (with instanced
+                                                                                                  // shaders, OpenGL 4.3). Ignored on OpenGL ES / WebGL.
+                                                                                                  // Default: disabled
+            MeshBuilder& withUsage(MeshUsage usage);                                              // How often the mesh is updated (Static, Dynamic or Stream).
+                                                                                                  // Stream meshes are not stored in a geometry pool.
+                                                                                                  // Default: Static
+            MeshBuilder& withLayout(MeshLayout layout);                                           // Store the vertex attributes Interleaved (in one buffer) or
+                                                                                                  // Separate (a buffer per attribute). Separate meshes are not
+                                                                                                  // stored in a geometry pool. Default: Interleaved
+            MeshBuilder& withRetainCpuData(bool enabled);                                         // Keep the vertex attributes and indices in CPU memory after
+                                                                                                  // the GPU upload (used by getPositions(), getIndices(), ...
+                                                                                                  // and updateAttribute()). When disabled, update() must set
+                                                                                                  // all attributes and indices again. Default: enabled
             
             std::shared_ptr<Mesh> build();
         private:
@@ -104,11 +128,16 @@ namespace sre {
             std::map<std::string,std::vector<glm::vec3>> attributesVec3;
             std::map<std::string,std::vector<glm::vec4>> attributesVec4;
             std::map<std::string,std::vector<glm::i32vec4>> attributesIVec4;
+            std::map<std::string,VertexAttributeFormat> attributeFormats;
             std::vector<MeshTopology> meshTopology = {MeshTopology::Triangles};
             std::vector<std::vector<uint32_t>> indices;
             Mesh *updateMesh = nullptr;
             bool recomputeNormals = false;
             bool recomputeTangents = false;
+            bool useGeometryPool = false;
+            MeshUsage usage = MeshUsage::Static;
+            MeshLayout layout = MeshLayout::Interleaved;
+            bool retainCpuData = true;
             std::string name;
             float lineWidth {1.0f};
             glm::vec3 location {0.0f, 0.0f, 0.0f};
@@ -125,17 +154,31 @@ namespace sre {
 
         int getVertexCount();                                       // Number of vertices in mesh
 
-        std::vector<glm::vec3> getPositions();                      // Get position vertex attribute
-        std::vector<glm::vec3> getNormals();                        // Get normal vertex attribute
-        std::vector<glm::vec4> getUVs();                            // Get uv vertex attribute
-        std::vector<glm::vec4> getColors();                         // Get color vertex attribute
-        std::vector<glm::vec4> getTangents();                       // Get tangent vertex attribute (the w component contains the orientation of bitangent:
+        const std::vector<glm::vec3>& getPositions();               // Get position vertex attribute
+        const std::vector<glm::vec3>& getNormals();                 // Get normal vertex attribute
+        const std::vector<glm::vec4>& getUVs();                     // Get uv vertex attribute
+        const std::vector<glm::vec4>& getColors();                  // Get color vertex attribute
+        const std::vector<glm::vec4>& getTangents();                // Get tangent vertex attribute (the w component contains the orientation of bitangent:
                                                                     //                                                                                  -1 or 1)
-        std::vector<float> getParticleSizes();                      // Get particle size vertex attribute
+        const std::vector<float>& getParticleSizes();               // Get particle size vertex attribute
+                                                                    // (the vertex attributes are empty if the CPU data is not retained)
+        bool hasCpuData();                                          // False if the vertex attributes and indices were freed after the
+                                                                    // GPU upload (see MeshBuilder::withRetainCpuData())
+
+        void updateAttribute(const std::string& name, const std::vector<float>& values, int firstVertex = 0);
+        void updateAttribute(const std::string& name, const std::vector<glm::vec2>& values, int firstVertex = 0);
+        void updateAttribute(const std::string& name, const std::vector<glm::vec3>& values, int firstVertex = 0);
+        void updateAttribute(const std::string& name, const std::vector<glm::vec4>& values, int firstVertex = 0);
+        void updateAttribute(const std::string& name, const std::vector<glm::i32vec4>& values, int firstVertex = 0);
+                                                                    // Overwrite the values of a vertex attribute from firstVertex in
+                                                                    // the existing vertex buffer. Faster than update(), since the
+                                                                    // vertex layout, vertex count and vertex array objects are kept
+                                                                    // (use update() to change those). Bounds are only recomputed
+                                                                    // when "position" changes
 
         int getIndexSets();                                         // Return the number of index sets
         MeshTopology getMeshTopology(int indexSet=0);               // Mesh topology used
-        const std::vector<uint32_t>& getIndices(int indexSet=0);    // Indices used in the mesh
+        const std::vector<uint32_t>& getIndices(int indexSet=0);    // Indices used in the mesh (empty if the CPU data is not retained)
         int getIndicesSize(int indexSet=0);                         // Return the size of the index set
 
         template<typename T>
@@ -143,6 +186,7 @@ namespace sre {
                                                                     //                                                          glm::vec3,glm::vec4,glm::i32vec4
 
         std::pair<int,int> getType(const std::string& name);        // return element type, element count
+        VertexAttributeFormat getAttributeFormat(const std::string& name); // storage format of the vertex attribute on the GPU
 
         std::vector<std::string> getAttributeNames();               // Names of the vertex attributes
 
@@ -161,12 +205,17 @@ namespace sre {
         void setScaling(float newScaling);                          // Scale the mesh in the same amount in all directions
         void setMaterial(std::shared_ptr<Material> newMaterial);    // Set the material for the mesh
         void draw(RenderPass& renderPass);                          // Draw the mesh using renderPass
+        bool isInGeometryPool();                                    // True if the mesh data is stored in a shared geometry pool
+        MeshUsage getUsage();                                       // How often the mesh is updated
+        MeshLayout getLayout();                                     // How the vertex attributes are stored on the GPU
     private:
         struct Attribute {
             int offset;
             int elementCount;
             int dataType;
             int attributeType; // GL_BYTE, GL_UNSIGNED_BYTE, GL_SHORT, GL_UNSIGNED_SHORT, GL_INT, GL_UNSIGNED_INT
+            bool normalized;   // integer data is mapped to [0;1] or [-1;1]
+            VertexAttributeFormat format; // format of the values on the GPU
             int enabledAttributes[10];
             int disabledAttributes[10];
         };
@@ -176,11 +225,21 @@ namespace sre {
             uint32_t type;
         };
 
-        Mesh       (std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material);
-        void update(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material);
+        Mesh       (std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material, bool useGeometryPool, std::map<std::string,VertexAttributeFormat> attributeFormats, MeshUsage usage, MeshLayout layout, bool retainCpuData);
+        void update(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material, bool useGeometryPool, std::map<std::string,VertexAttributeFormat> attributeFormats, MeshUsage usage, MeshLayout layout, bool retainCpuData);
 
         void updateIndexBuffers();
-        std::vector<float> getInterleavedData();
+        std::vector<float> getInterleavedData(bool fill);           // (fill=false only computes the attribute layout)
+        std::vector<float> getCompactInterleavedData(bool fill);    // tightly packed vertices using attributeFormats
+        void uploadVertices(int firstVertex, int count);            // interleave a range of vertices into the existing vertex buffer
+        void uploadAttributeBuffer(const std::string& name, int firstVertex, int count, bool reallocate); // (MeshLayout::Separate)
+        void packAttribute(const std::string& name, const Attribute& attribute, int firstVertex, int count, char* dest, int stride);
+        // values of the attribute in CPU memory (i32vec4 values as int bits)
+        const float* getAttributeValues(const std::string& name, const Attribute& attribute, size_t& size, int& components);
+        void releaseAttributeBuffers(bool all);                     // delete the buffers of removed attributes (or all)
+        template<typename T>
+        void updateAttributeValues(std::map<std::string,std::vector<T>>& attributes, const std::string& name, const std::vector<T>& values, int firstVertex);
+        void computeBounds();
 
         int totalBytesPerVertex = 0;
         static uint16_t meshIdCount;
@@ -188,16 +247,41 @@ namespace sre {
 
         void setVertexAttributePointers(Shader* shader);
         std::vector<MeshTopology> meshTopology;
-        unsigned int vertexBufferId;
+        unsigned int vertexBufferId = 0;
         struct VAOBinding {
             long shaderId;
             unsigned int vaoID;
+            unsigned int vertexBufferVersion;                       // see Mesh::vertexBufferVersion
+        };
+        static constexpr int streamBufferCount = 3;
+        struct StreamBuffers {                                      // buffers rotated by MeshUsage::Stream meshes
+            unsigned int buffers[streamBufferCount] = {};
+            int index = 0;
+            void next(unsigned int& current);                       // keep current and continue with the next buffer (0 if not created)
+            void release(unsigned int current);                     // delete the other buffers
         };
+        MeshUsage usage = MeshUsage::Static;
+        StreamBuffers streamVertexBuffers;
+        StreamBuffers streamElementBuffers;
+        unsigned int vertexBufferVersion = 0;                       // changed when a vertex buffer is replaced (the attribute pointers
+                                                                    // of the vertex array objects must be set again)
+        struct AttributeBuffer {                                    // vertex buffer of an attribute (MeshLayout::Separate)
+            unsigned int bufferId = 0;
+            int stride = 0;
+            StreamBuffers streamBuffers;
+        };
+        MeshLayout layout = MeshLayout::Interleaved;
+        std::map<std::string,AttributeBuffer> attributeBuffers;
+        bool retainCpuData = true;
         std::map<unsigned int, VAOBinding> shaderToVertexArrayObject;
         unsigned int elementBufferId = 0;
         std::vector<ElementBufferData> elementBufferOffsetCount;
         int vertexCount;
         int dataSize;
+
+        GeometryPool* geometryPool = nullptr;                       // (if any) owns the vertex and index buffers
+        int baseVertex = 0;                                         // first vertex in the geometry pool
+        std::string getLayoutKey();                                 // identifies the vertex attribute layout (and line width)
         std::string name;
         std::map<std::string,Attribute> attributeByName;
         std::map<std::string,std::vector<float>> attributesFloat;
@@ -205,6 +289,7 @@ namespace sre {
         std::map<std::string,std::vector<glm::vec3>> attributesVec3;
         std::map<std::string,std::vector<glm::vec4>> attributesVec4;
         std::map<std::string,std::vector<glm::i32vec4>> attributesIVec4;
+        std::map<std::string,VertexAttributeFormat> attributeFormats;
 
         std::vector<std::vector<uint32_t>> indices;
 
@@ -215,6 +300,7 @@ namespace sre {
 
         friend class RenderPass;
         friend class Inspector;
+        friend class GeometryPool;
 
         bool hasAttribute(std::string name);
 
@@ -0,0 +1,21 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    /**
+     * Describes how the vertex attributes of a mesh are stored on the GPU
+     */
+    enum class MeshLayout {
+        Interleaved,    // All vertex attributes in a single buffer (one vertex after another)
+        Separate        // Each vertex attribute in its own buffer. Updating an attribute only uploads that attribute, and
+                        // shaders using few attributes (such as depth-only passes) only fetch the buffers they use
+    };
+}
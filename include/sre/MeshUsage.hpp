@@ -0,0 +1,22 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    /**
+     * Describes how often the data of a mesh is updated
+     */
+    enum class MeshUsage {
+        Static,         // Created once and drawn many times (GL_STATIC_DRAW)
+        Dynamic,        // Updated occasionally (GL_DYNAMIC_DRAW)
+        Stream          // Updated every frame (GL_STREAM_DRAW). Each update writes to the next of 3 buffers, such that
+                        // the CPU never waits for the GPU to finish reading the data of the previous frames
+    };
+}
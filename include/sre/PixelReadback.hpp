@@ -0,0 +1,49 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include "sre/Color.hpp"
+#include "sre/impl/Export.hpp"
+#include "sre/impl/GL.hpp"
+#include <vector>
+
+namespace sre {
+    /**
+     * Result of an asynchronous framebuffer read (see RenderPass::readPixelsAsync() and RenderPass::readRawPixelsAsync()).
+     *
+     * The pixels are copied into a pixel pack buffer on the GPU. The buffer is only mapped once a fence placed after
+     * the copy has signalled (typically 1-2 frames later), which avoids the pipeline stall of glReadPixels(). Poll
+     * isReady() once per frame, and get the pixels when it returns true.
+     */
+    class DllExport PixelReadback {
+    public:
+        ~PixelReadback();
+
+        bool isReady();                                         // True when the pixels can be read without blocking
+        std::vector<Color> getPixels();                         // Pixels of RenderPass::readPixelsAsync() (blocks if not ready)
+        std::vector<glm::u8vec4> getRawPixels();                // Pixels of RenderPass::readRawPixelsAsync() (blocks if not ready)
+        glm::ivec2 getSize();                                   // Size of the read rectangle
+    private:
+        PixelReadback(glm::ivec2 size, bool raw);
+        PixelReadback(const PixelReadback&) = delete;
+        void read(int x, int y);                                // issue the read of the currently bound framebuffer
+        void resolve();                                         // copy the pixels to client memory (waiting for the fence)
+        void release();                                         // return the pixel pack buffer to the pool
+
+        glm::ivec2 size;
+        bool raw;                                               // GL_UNSIGNED_BYTE (true) or GL_FLOAT (false) pixels
+        size_t byteSize;
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        std::vector<char> data;                                 // pixels copied from the pixel pack buffer
+        bool resolved = false;
+
+        friend class RenderPass;
+    };
+}
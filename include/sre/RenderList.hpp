@@ -0,0 +1,62 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "glm/glm.hpp"
+#include "sre/RenderPass.hpp"
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    class Mesh;
+    class Material;
+
+    /// A RenderList is a retained list of draw calls, which can be rendered in multiple frames. Useful for static
+    /// content (such as a large static model), since the normal matrices, world space bounds and the state part of the
+    /// sort keys are computed when the draw calls are added (or updated) - not when rendered.
+    ///
+    /// Draw calls are identified by a handle, which remains valid until the draw call is removed.
+    /// A RenderList is added to a RenderPass using RenderPass::draw(renderList) in constant time. The RenderList must
+    /// not be modified before the RenderPass is finished.
+    ///
+    /// Note that if the mesh of a draw call is updated (changing the bounds), then the draw call should be updated too.
+    class DllExport RenderList {
+    public:
+        typedef uint32_t Handle;
+
+        static std::shared_ptr<RenderList> create();
+
+        Handle draw(std::shared_ptr<Mesh>& mesh,                        // Add a draw call. Returns a handle to the draw call
+                    glm::mat4 modelTransform,
+                    std::shared_ptr<Material>& material,
+                    int subMesh = 0);
+
+        void update(Handle handle, glm::mat4 modelTransform);           // Update transform (and the derived data) of a draw call
+        void update(Handle handle, std::shared_ptr<Material>& material);// Update material of a draw call
+        void remove(Handle handle);                                     // Remove a draw call (the handle is no longer valid)
+        bool isValid(Handle handle);                                    // True if handle refers to a draw call in the list
+        void clear();                                                   // Remove all draw calls
+
+        size_t size();                                                  // Number of draw calls
+    private:
+        RenderList() = default;
+        std::vector<RenderPass::RenderQueueObj> renderQueue;            // draw calls (densely packed)
+        std::vector<RenderPass::PrecomputedObj> precomputed;            // derived data of draw calls
+        std::vector<std::shared_ptr<Mesh>> meshes;                      // keeps meshes and materials alive
+        std::vector<std::shared_ptr<Material>> materials;
+        std::vector<Handle> indexToHandle;
+        std::vector<uint32_t> handleToIndex;                            // index in renderQueue (or invalidIndex)
+        std::vector<Handle> freeHandles;
+
+        static constexpr uint32_t invalidIndex = 0xFFFFFFFF;
+
+        friend class RenderPass;
+    };
+}
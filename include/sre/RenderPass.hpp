@@ -12,21 +12,34 @@
 #include "sre/Mesh.hpp"
 #include "sre/Material.hpp"
 #include "sre/WorldLights.hpp"
+#include "sre/PixelReadback.hpp"
 #include <string>
 #include <functional>
+#include <map>
 
 #include "sre/impl/Export.hpp"
+#include "sre/impl/FrameArena.hpp"
 #include "SpriteBatch.hpp"
 #include "Skybox.hpp"
 
 namespace sre {
     class Renderer;
+    class RenderList;
 
     class Shader;
     class Material;
     class RenderStats;
     class Framebuffer;
 
+    enum class SortMode {
+        None,                       // Draw calls are rendered in the order draw() was called (default)
+        StateChanges,               // Opaque draw calls are sorted by shader, material and mesh (then front-to-back)
+                                    // to minimize state changes
+        FrontToBack                 // Opaque draw calls are sorted front-to-back (then by shader, material and mesh)
+                                    // to maximize early depth rejection
+    };                              // For both sort modes transparent draw calls (blending or no depth write) are
+                                    // rendered after opaque draw calls in back-to-front order
+
     // A render pass encapsulates some render states and allows adding draw-calls.
     // Materials and shaders are assumed not to be modified during a renderpass.
     // Note that only one render pass object can be active at a time.
@@ -54,6 +67,21 @@ namespace sre {
 
             RenderPassBuilder& withFramebuffer(std::shared_ptr<Framebuffer> framebuffer);
             RenderPassBuilder& withImGuiArrowMouseCursor(const bool& drawArrow);                // Ask ImGui to render an "arrow" mouse cursor
+            RenderPassBuilder& withSortMode(SortMode sortMode);                                    // Sort the draw calls before rendering
+                                                                                                   // Default: SortMode::None
+            RenderPassBuilder& withFrustumCulling(bool enabled = true);                            // Skip draw calls where the mesh bounds are outside the
+                                                                                                   // camera frustum. Default: enabled
+            RenderPassBuilder& withDepthPrepass(bool enabled = true);                              // Render the depth of opaque draw calls first (using
+                                                                                                   // depth only variants of the shaders), then shade them
+                                                                                                   // with depth test GL_LEQUAL and depth writes disabled.
+                                                                                                   // Reduces overdraw of expensive fragment shaders.
+                                                                                                   // Default: disabled
+            RenderPassBuilder& withOcclusionCulling(bool enabled = true);                          // Skip draw calls of opaque objects hidden behind other
+                                                                                                   // objects using occlusion queries. Objects occluded in
+                                                                                                   // the previous frame only draw their bounding box (with a
+                                                                                                   // query) and are rendered conditionally on the result.
+                                                                                                   // Works best with SortMode::FrontToBack (occluders first).
+                                                                                                   // Requires OpenGL 3.3 / WebGL 2.0. Default: disabled
             RenderPass build();
         private:
             RenderPassBuilder() = default;
@@ -76,6 +104,10 @@ namespace sre {
 
             bool gui = true;
             bool drawImGuiArrowMouseCursor = false;
+            SortMode sortMode = SortMode::None;
+            bool frustumCulling = true;
+            bool depthPrepass = false;
+            bool occlusionCulling = false;
 
             explicit RenderPassBuilder(RenderStats* renderStats);
             friend class RenderPass;
@@ -89,9 +121,25 @@ namespace sre {
         RenderPass& operator=(RenderPass&& other) = delete;             // RenderPass objects cannot be reused.
         virtual ~RenderPass();
 
-        void drawLines(const std::vector<glm::vec3> &verts,             // Draws worldspace lines.
-                       Color color = {1.0f, 1.0f, 1.0f, 1.0f},          // Note that this member function is not expected
-                       MeshTopology meshTopology = MeshTopology::Lines);// to perform as efficient as draw()
+        void drawLines(const std::vector<glm::vec3> &verts,             // Draws worldspace lines (or other primitives given by
+                       Color color = {1.0f, 1.0f, 1.0f, 1.0f},          // meshTopology) as debug geometry (see drawLine()).
+                       MeshTopology meshTopology = MeshTopology::Lines);
+
+        void drawLines(const std::vector<glm::vec3> &verts,             // Similar to drawLines above, but using a color per vertex
+                       const std::vector<Color> &colors,
+                       MeshTopology meshTopology = MeshTopology::Lines);
+
+        void drawLine(glm::vec3 from, glm::vec3 to,                     // Immediate mode debug drawing (in worldspace). The geometry
+                      Color color = {1.0f, 1.0f, 1.0f, 1.0f});          // of the render pass is streamed to a single vertex buffer
+        void drawLine(glm::vec3 from, glm::vec3 to,                     // and rendered unlit (without culling) after the other draw
+                      Color colorFrom, Color colorTo);                  // calls, using at most one draw call per primitive type
+        void drawPoint(glm::vec3 position,                              // (points, lines and triangles).
+                       Color color = {1.0f, 1.0f, 1.0f, 1.0f});
+        void drawTriangle(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2,
+                          Color color = {1.0f, 1.0f, 1.0f, 1.0f});
+        void drawWireBox(glm::vec3 min, glm::vec3 max,                  // Draws the edges of an axis aligned box (in the space
+                         Color color = {1.0f, 1.0f, 1.0f, 1.0f},        // given by transform)
+                         const glm::mat4& transform = glm::mat4(1));
 
         void draw(std::shared_ptr<Mesh>& mesh,                          // Draws a mesh using the given transform and material.
                   glm::mat4 modelTransform,                             // The modelTransform defines the modelToWorld
@@ -101,12 +149,38 @@ namespace sre {
                   glm::mat4 modelTransform,                             // The modelTransform defines the modelToWorld transformation
                   std::vector<std::shared_ptr<Material>> materials);    // The number of materials must match the size of index sets in the model
 
+        void drawInstanced(std::shared_ptr<Mesh>& mesh,                 // Draws count instances of the mesh using a single draw call.
+                  const glm::mat4* modelTransforms,                     // The material must use an instanced shader (S_INSTANCED).
+                  size_t count,                                         // The modelTransforms are streamed directly to the GPU
+                  std::shared_ptr<Material>& material);                 // when the renderpass is finished (the data must be
+                                                                        // kept valid until then)
+
+        void drawInstanced(std::shared_ptr<Mesh>& mesh,                 // Similar to drawInstanced above, but also streams
+                  const glm::mat4* modelTransforms,                     // per-instance vec4 attributes (such as a "color"
+                  size_t count,                                         // attribute). Each attribute must point to count
+                  std::shared_ptr<Material>& material,                  // values and is bound to the shader attribute with
+                  const std::map<std::string, const glm::vec4*>& instanceAttributes); // the same name (must not exist in the mesh)
+
+        void draw(std::shared_ptr<RenderList>& renderList);            // Draws the draw calls of a RenderList (in constant time).
+                                                                        // The draw calls are rendered after the draw calls of the
+                                                                        // renderpass (and recorders). The RenderList must not be
+                                                                        // modified before the renderpass is finished
+
         void draw(std::shared_ptr<SpriteBatch>& spriteBatch,            // Draws a spriteBatch using modelTransform
                   glm::mat4 modelTransform = glm::mat4(1));             // using a model-to-world transformation
 
         void draw(std::shared_ptr<SpriteBatch>&& spriteBatch,           // Draws a spriteBatch using modelTransform
                   glm::mat4 modelTransform = glm::mat4(1));             // using a model-to-world transformation
 
+        class Recorder;
+        std::shared_ptr<Recorder> createRecorder();                     // Create a recording context, which allows draw calls to be
+                                                                        // recorded from a worker thread. A recorder must only be used by
+                                                                        // one thread at a time and recording must be completed before
+                                                                        // the renderpass is finished. The recorded draw calls are
+                                                                        // rendered after the draw calls of the renderpass itself in the
+                                                                        // order the recorders were created.
+                                                                        // Must be called from the render thread.
+
         void drawImGuiArrowMousCursor();                                // Render the ImGui "arrow" cursor
 
         void blit(std::shared_ptr<Texture> texture,                     // Render texture to screen
@@ -129,9 +203,23 @@ namespace sre {
                                           unsigned int height = 1,
                                           bool readFromScreen = false);
 
+        std::shared_ptr<PixelReadback> readPixelsAsync(unsigned int x,  // Asynchronous versions of 'readPixels' and 'readRawPixels'. The pixels are
+                                          unsigned int y,               // copied on the GPU and become available (see PixelReadback::isReady()) once
+                                          unsigned int width = 1,       // the GPU has finished the frame, which avoids stalling the pipeline
+                                          unsigned int height = 1,
+                                          bool readFromScreen = false);
+
+        std::shared_ptr<PixelReadback> readRawPixelsAsync(unsigned int x,
+                                          unsigned int y,
+                                          unsigned int width = 1,
+                                          unsigned int height = 1,
+                                          bool readFromScreen = false);
+
         void finishGPUCommandBuffer();                                  // GPU command buffer (must be called when
                                                                         // profiling GPU time - should not be called
-                                                                        // when not profiling)
+                                                                        // when not profiling). Note that the GPU time
+                                                                        // of render passes is measured without stalling
+                                                                        // the pipeline in RenderStats::renderPassTimings
 
         void finish();
         bool isFinished();
@@ -145,12 +233,32 @@ namespace sre {
         static FrameInspector frameInspector;
 
         bool mIsFinished = false;
-        struct RenderQueueObj{
-            std::shared_ptr<Mesh> mesh;
+        struct PrecomputedObj{                                          // data derived from a draw call (see RenderList)
+            glm::mat3 modelInverseTranspose;
+            glm::vec3 worldCenter;                                      // world space bounds (center of bounds used for depth sorting)
+            glm::vec3 worldExtent;
+            bool cullable;
+            bool transparent;
+            uint64_t stateKey;                                          // shader, material and mesh part of the sort key
+        };
+        struct RenderQueueObj{                                          // POD (mesh and material are kept alive by the renderpass)
+            Mesh* mesh;
             glm::mat4 modelTransform;
-            std::shared_ptr<Material> material;
+            Material* material;
             int subMesh = 0;
+            int instancedDraw = -1;                                     // index in instancedDraws (or -1)
+            const PrecomputedObj* precomputed = nullptr;                // set for draw calls of a RenderList
+        };
+        static void precompute(const RenderQueueObj& rqObj, PrecomputedObj& precomputed);
+        struct InstancedDraw{                                           // draw call added using drawInstanced()
+            const glm::mat4* modelTransforms;
+            size_t count;
+            std::vector<std::pair<GLint, const glm::vec4*>> attributes; // attribute location and data
+            size_t modelTransformsOffset = 0;                           // offsets in the instance buffer
+            size_t normalMatricesOffset = 0;
+            std::vector<size_t> attributesOffset;
         };
+        std::vector<InstancedDraw> instancedDraws;
         struct GlobalUniforms{
             glm::mat4* g_view;
             glm::mat4* g_projection;
@@ -160,9 +268,56 @@ namespace sre {
             glm::vec4* g_lightColorRange;
             glm::vec4* g_lightPosType;
         };
-        std::vector<RenderQueueObj> renderQueue;
-
-        void drawInstance(RenderQueueObj& rqObj);                       // perform the actual rendering
+        FrameVector<RenderQueueObj> renderQueue;                        // allocated in the frame arena of the renderer
+        FrameVector<std::shared_ptr<Mesh>> meshesInUse;                 // keeps meshes and materials in the render queue alive
+        FrameVector<std::shared_ptr<Material>> materialsInUse;
+        void keepAlive(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material);
+        std::vector<std::shared_ptr<Recorder>> recorders;
+        void mergeRecorders();                                          // append draw calls of recorders to renderQueue
+        FrameVector<std::shared_ptr<RenderList>> renderLists;
+        void mergeRenderLists();                                        // append draw calls of render lists to renderQueue
+
+        struct DebugVertex {
+            glm::vec3 position;
+            glm::vec4 color;                                            // linear space
+        };
+        FrameVector<DebugVertex> debugPoints;                           // immediate mode debug geometry (one list per primitive type)
+        FrameVector<DebugVertex> debugLines;
+        FrameVector<DebugVertex> debugTriangles;
+        void addDebugGeometry(const std::vector<glm::vec3>& verts, const glm::vec4* colors, bool colorPerVertex, MeshTopology meshTopology);
+        bool hasDebugGeometry();
+        void drawDebugGeometry();                                       // stream and draw the debug geometry
+        std::shared_ptr<PixelReadback> readAsync(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen, bool raw);
+
+        void drawRenderQueue();                                         // render the queue (combining draw calls into instanced draw calls)
+        void drawInstance(size_t index, int instanceCount = 0, size_t firstInstance = 0, bool depthOnly = false, // perform the actual rendering of renderQueue[index]
+                          int drawCount = 0, size_t indirectOffset = 0); // drawCount > 0 uses a multi draw call (commands at indirectOffset)
+        Shader* depthPrepassShader(const RenderQueueObj& rqObj);       // depth only shader (or nullptr if not drawn in the depth pre-pass)
+        void computeNormalMatrices();                                   // compute normal matrices of the render queue (if used)
+        FrameVector<glm::mat3> normalMatrices;                          // transpose(inverse(mat3(model))) per render queue entry
+        const glm::mat3* normalMatrix(size_t index);                    // normal matrix of renderQueue[index] (or nullptr if not computed)
+        enum class OcclusionTest : uint8_t {
+            None,                                                       // drawn without a query
+            DrawQuery,                                                  // visible in the previous frame (the draw call is queried)
+            BoxQuery                                                    // occluded in the previous frame (the bounds are queried)
+        };
+        struct OcclusionQuery {
+            GLuint query;
+            OcclusionTest test;
+        };
+        FrameVector<OcclusionQuery> occlusionQueries;                   // per render queue entry (empty if occlusion culling is disabled)
+        void prepareOcclusionQueries();                                 // read results of the previous frame and assign queries
+        void drawOcclusionQueried(size_t index);                        // draw renderQueue[index] using its occlusion query
+        void drawOcclusionBox(size_t index, GLuint query);              // query the bounding box of renderQueue[index]
+        bool isDepthPrepassed(size_t index);                            // true if renderQueue[index] is drawn in the depth pre-pass
+        void writeDrawUniforms();                                       // upload model and normal matrices of all draw calls at once
+        FrameVector<uint32_t> drawSlots;                                // slot in the draw uniforms per render queue entry (the last
+                                                                        // entry is the debug geometry). Empty if the block is unused
+        void drawMesh(Mesh* mesh, int subMesh, int instanceCount);      // issue draw call (instanceCount 0 means not instanced)
+        void setInstanceAttributePointers(Shader* shader, size_t modelOffset, size_t modelStride, size_t normalMatrixOffset, size_t normalMatrixStride);
+        void cullRenderQueue(size_t first);                             // remove draw calls (from first) outside the camera frustum
+        void sortRenderQueue();                                         // sort renderQueue using builder.sortMode
+        uint64_t computeSortKey(const RenderQueueObj& rqObj);           // packed 64-bit key (blend, shader, material, mesh, depth)
 
         RenderPass::RenderPassBuilder builder;
         explicit RenderPass(RenderPass::RenderPassBuilder& builder);
@@ -170,17 +325,47 @@ namespace sre {
         void setupShaderRenderPass(Shader *shader);
         void setupShaderRenderPass(const GlobalUniforms& globalUniforms);
         void setupGlobalShaderUniforms();
-        void setupShader(const glm::mat4 &modelTransform, Shader *shader);
+        void setupShader(const glm::mat4 &modelTransform, Shader *shader, const glm::mat3* modelInverseTranspose, size_t drawIndex);
 
         Shader* lastBoundShader = nullptr;
         Material* lastBoundMaterial = nullptr;
-        int64_t lastBoundMeshId = -1;
+        const void* lastBoundMesh = nullptr;                            // Mesh (or GeometryPool of pooled meshes) of the bound vertex
+                                                                        // array object (mesh ids are 16 bit and may be reused)
 
         glm::mat4 projection;
+        glm::mat3 viewInverseTranspose;
+        size_t drawUniformsOffset = 0;                                  // offset of the draw uniforms in the draw uniform buffer
+        size_t drawUniformsRangeSize = 0;                               // bytes per range of Shader::drawUniformBlockDraws slots
+        int64_t boundDrawUniformsRange = -1;                            // range bound to Shader::drawUniformBindingIndex
         glm::uvec2 viewportOffset;
         glm::uvec2 viewportSize;
 
         friend class Renderer;
         friend class Inspector;
+        friend class RenderList;
+    };
+
+    // Draw call recording context of a RenderPass (see RenderPass::createRecorder()).
+    // Draw calls are culled while recording. Meshes and materials must be created on the render thread.
+    class DllExport RenderPass::Recorder {
+    public:
+        void draw(std::shared_ptr<Mesh>& mesh,                          // Records a mesh using the given transform and material.
+                  glm::mat4 modelTransform,
+                  std::shared_ptr<Material>& material);
+
+        void draw(std::shared_ptr<Mesh>& mesh,                          // Records a mesh using the given transform and materials.
+                  glm::mat4 modelTransform,                             // The number of materials must match the size of index sets in the model
+                  std::vector<std::shared_ptr<Material>> materials);
+    private:
+        Recorder() = default;
+        FrameVector<RenderQueueObj> renderQueue;                        // allocated on the heap (the frame arena is not thread-safe)
+        FrameVector<std::shared_ptr<Mesh>> meshesInUse;
+        FrameVector<std::shared_ptr<Material>> materialsInUse;
+        bool frustumCulling = false;
+        glm::vec4 frustumPlanes[6];
+        int objectsSubmitted = 0;
+        int objectsCulled = 0;
+        bool finished = false;
+        friend class RenderPass;
     };
 }
@@ -8,8 +8,15 @@
 #pragma once
 
 #include "sre/impl/Export.hpp"
+#include <string>
+#include <vector>
 
 namespace sre {
+    struct DllExport RenderPassTiming {
+        std::string name;                                     // Name of the render pass
+        float gpuMilliseconds;                                // GPU time of RenderPass::finish()
+    };
+
     // Render stats maintained by SimpleRenderEngine
     struct DllExport RenderStats {
         int frame=0;                                          // The frameid the render stat is captured
@@ -17,6 +24,7 @@ namespace sre {
         int meshBytes=0;                                      // Size of allocated meshes in bytes
         int meshBytesAllocated=0;                             // Size of allocated meshes in bytes this frame
         int meshBytesDeallocated=0;                           // Size of deallocated meshes in bytes this frame
+        int meshBytesUploaded=0;                              // Size of vertex and index data uploaded to meshes in bytes this frame
         int textureCount=0;                                   // Number of allocated textures
         int textureBytes=0;                                   // Size of allocated textures in bytes
         int textureBytesAllocated=0;                          // Size of allocated textures in bytes this frame
@@ -26,5 +34,19 @@ namespace sre {
         int stateChangesShader=0;                             // Number of state changes for shaders
         int stateChangesMaterial=0;                           // Number of state changes for materials
         int stateChangesMesh=0;                               // Number of state changes for meshes
+        int objectsSubmitted=0;                               // Number of draw calls added to render passes
+        int objectsCulled=0;                                  // Number of draw calls removed by frustum culling
+        int objectsDrawn=0;                                   // Number of draw calls remaining after frustum culling
+        int glCallsIssued=0;                                  // Number of GL state changes issued
+        int glCallsSkipped=0;                                 // Number of GL state changes skipped (value already set)
+        int occlusionQueries=0;                               // Number of occlusion queries issued
+        int objectsOccluded=0;                                // Number of draw calls skipped (or conditionally rendered) as
+                                                              // their bounds were occluded in the previous frame
+        int objectsVisible=0;                                 // Number of occlusion tested draw calls visible in the previous frame
+        int gpuFrame=-1;                                      // The frameid measured by the GPU timers. Results are read without
+                                                              // stalling the pipeline and arrive a few frames late (-1 if GPU
+                                                              // timers are not supported)
+        float gpuMilliseconds=0;                              // GPU time of the render passes of gpuFrame
+        std::vector<RenderPassTiming> renderPassTimings;      // GPU time per render pass of gpuFrame
     };
 }
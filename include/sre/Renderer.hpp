@@ -14,8 +14,14 @@
 #include "sre/RenderPass.hpp"
 
 #include "sre/impl/Export.hpp"
+#include "sre/impl/FrameArena.hpp"
+#include "sre/impl/GLState.hpp"
+#include "sre/impl/UniformRingBuffer.hpp"
 #include "RenderStats.hpp"
 #include "Mesh.hpp"
+#include "FrameGraph.hpp"
+#include <map>
+#include <unordered_map>
 
 
 namespace sre {
@@ -26,6 +32,7 @@ namespace sre {
     class Shader;
     class Shader;
     class VR;
+    class GeometryPool;
 
     struct RenderInfo{
         bool useFramebufferSRGB = false;
@@ -107,8 +114,79 @@ namespace sre {
         std::vector<SpriteAtlas*> spriteAtlases;
 
         void initGlobalUniformBuffer();
-        GLuint globalUniformBuffer = 0;
-        GLuint globalUniformBufferSize = 0;
+        UniformRingBuffer globalUniforms;                   // global uniforms of the render passes
+        GLuint globalUniformBufferSize = 0;                 // size of the global uniform block
+
+        FrameArena frameArena;                              // per-frame allocations (reset in swapWindow())
+        GLState glState{&renderStats};                      // shadows GL state to skip redundant state changes
+
+        void initInstanceBuffer();
+        GLuint instanceBuffer = 0;                          // per-instance data (model transforms) streamed each render pass
+
+        void initDrawUniformBuffer();
+        UniformRingBuffer drawUniforms;                     // per-draw data (model and normal matrices) of the render passes
+        GLint uniformBufferOffsetAlignment = 256;
+
+        std::shared_ptr<Material> debugMaterial;            // unlit (vertex color) material of RenderPass debug geometry
+        GLuint debugVertexBuffer = 0;                       // debug geometry streamed each render pass
+        size_t debugVertexBufferSize = 0;
+        GLuint debugVertexArray = 0;
+
+        struct OcclusionQuery {                             // occlusion state of a draw call (see
+            GLuint query = 0;                               // RenderPass::RenderPassBuilder::withOcclusionCulling())
+            bool pending = false;                           // result of the last query not read yet
+            bool occluded = false;                          // last available result
+            int lastFrame = 0;                              // frame the draw call was last rendered
+        };
+        bool initOcclusionQueries();                        // returns false if occlusion queries are not supported
+        void releaseUnusedOcclusionQueries();               // return query objects of draw calls no longer rendered
+        GLuint acquireQuery(std::vector<GLuint>& pool);     // get a query object from the pool
+        std::unordered_map<uint64_t, OcclusionQuery> occlusionQueries;  // keyed by draw call (mesh, material and position)
+        std::vector<GLuint> occlusionQueryPool;             // unused query objects
+        bool conditionalRenderSupported = false;            // glBeginConditionalRender (OpenGL 3.0, not OpenGL ES / WebGL)
+        std::shared_ptr<Shader> occlusionBoxShader;         // draws bounding boxes without color and depth writes
+        std::shared_ptr<Mesh> occlusionBoxMesh;             // cube [-1;1]
+        GLint occlusionBoxUniformLocation = -1;
+
+        struct GpuTimer {                                   // GL_TIMESTAMP queries around RenderPass::finish()
+            std::string name;
+            int frame;
+            GLuint begin;
+            GLuint end;
+        };
+        void beginGpuTimer(const std::string& name);        // no-op if timer queries are not supported (OpenGL ES / WebGL)
+        void endGpuTimer();
+        void readGpuTimers();                               // update the GPU timings of renderStats (without blocking)
+        bool gpuTimersSupported = false;
+        std::vector<GpuTimer> gpuTimers;                    // issued timers waiting for their results (in frame order)
+        std::vector<GLuint> timerQueryPool;                 // unused timestamp query objects
+
+        GeometryPool* getGeometryPool(const std::string& layout, int bytesPerVertex); // get (or create) the pool of a vertex layout
+        std::vector<std::unique_ptr<GeometryPool>> geometryPools;
+        bool geometryPoolSupported = false;                 // requires base vertex draw calls (OpenGL 3.2)
+        bool multiDrawIndirectSupported = false;            // OpenGL 4.3
+        GLuint indirectBuffer = 0;                          // multi draw commands streamed each render pass
+
+        struct PixelPackBuffer {
+            GLuint buffer;
+            size_t size;
+        };
+        GLuint acquirePixelPackBuffer(size_t size);         // get a pixel pack buffer of at least size bytes
+        void releasePixelPackBuffer(GLuint buffer, size_t size);
+        std::vector<PixelPackBuffer> pixelPackBuffers;      // unused buffers of finished PixelReadbacks (reused round robin)
+
+        struct TransientTexture {                           // texture of FrameGraph resources
+            FrameGraph::TextureDescription description;
+            std::shared_ptr<Texture> texture;
+            int lastFrame;
+        };
+        struct TransientFramebuffer {
+            std::shared_ptr<Framebuffer> framebuffer;
+            int lastFrame = 0;
+        };
+        void releaseUnusedTransientTextures();              // release textures and framebuffers of frame graphs not used recently
+        std::vector<TransientTexture> transientTextures;
+        std::map<std::vector<Texture*>, TransientFramebuffer> transientFramebuffers; // keyed by color and depth attachments
 
         friend class Mesh;
         friend class Mesh::MeshBuilder;
@@ -117,9 +195,12 @@ namespace sre {
         friend class Material;
         friend class Texture;
         friend class Framebuffer;
+        friend class PixelReadback;
+        friend class FrameGraph;
         friend class RenderPass;
         friend class Inspector;
         friend class SpriteAtlas;
+        friend class UniformSet;
         friend class VR;
         friend class RenderPass::RenderPassBuilder;
     };
@@ -199,9 +199,10 @@ public:
     bool playingEventsAborted();                                // Returns true if SDL event playback was aborted by the user
     void captureFrameToFile(RenderPass * renderPass,            // Capture image of frame generated by renderPass and write to path. If a multipass framebuffer is
                             std::filesystem::path path,         // attached to RenderPass, then set captureFromScreen = true. Finish RenderPass before calling.
-                            bool captureFromScreen= false);
+                            bool captureFromScreen= false);     // The image is read asynchronously and written once the GPU has finished the frame
     void captureFrame(RenderPass * renderPass,                  // Capture image of frame generated by renderPass and store in memory. If a multipass framebuffer is
                       bool captureFromScreen= false);           // attached to RenderPass, then set captureFromScreen = true. Finish RenderPass before calling.
+                                                                // The image is read asynchronously (allowing continuous capture without stalling)
     int numCapturedImages();                                    // Returns the number of captured images saved so far
     void writeCapturedImages(std::string fileName);             // Write all the images stored in memory to files
     void writeImage(std::vector<glm::u8vec4> image,             // Write a single image to the specified path
@@ -301,6 +302,13 @@ private:
     bool m_writingImages = false;
     std::vector<std::vector<glm::u8vec4>> m_image;
     std::vector<glm::ivec2> m_imageDimensions;
+    struct PendingCapture {
+        std::shared_ptr<PixelReadback> readback;
+        int imageIndex;                                         // index in m_image (-1 if written to path)
+        std::filesystem::path path;
+    };
+    std::vector<PendingCapture> m_pendingCaptures;              // captured images waiting for the GPU
+    void resolveCapturedImages(bool wait);                      // store (or write) the images of finished readbacks
     bool m_mouseDown = false;
     std::vector<SDL_Keycode> keyPressed;
     void addKeyPressed(SDL_Keycode keyCode);
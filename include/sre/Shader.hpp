@@ -65,6 +65,10 @@ namespace sre {
         int id;
         UniformType type;
         int arraySize;                  // 1 means not array
+        int textureUnit = -1;           // texture unit of samplers (assigned when the shader is linked)
+        int blockOffset = -1;           // byte offset in the material uniform block (-1 if not a member of the block)
+        int arrayStride = 0;            // std140 layout of block members
+        int matrixStride = 0;
     };
 
     enum class StencilFunc {
@@ -145,6 +149,17 @@ namespace sre {
      *   creating a specialized shader (as well as creating shaders in general) may caurse performance issues and should
      *   avoid during realtime rendering.
      *   Specialization constants must start start with 'S_' and must consist of capital letters, digits and underscore.
+     *
+     *   All built-in shaders (except skybox and blit) supports the S_INSTANCED specialization. Instanced shaders reads
+     *   g_model (and g_model_it) from per-instance vertex attributes, which allows the render pass to draw consecutive
+     *   draw calls with the same mesh, sub-mesh and material using a single instanced draw call (requires OpenGL 3.3 /
+     *   WebGL 2.0). Custom shaders can support instancing by including "global_uniforms_incl.glsl".
+     *
+     *   Material uniforms can be declared in a std140 uniform block named 'material_uniforms'. Each material then keeps
+     *   the values in a uniform buffer, which is only updated when a value changes and is bound using a single call
+     *   when the material is bound. Samplers cannot be members of the block. The block should be declared using
+     *   '#if __VERSION__ > 100' guards (like "global_uniforms_incl.glsl") to fall back to plain uniforms on
+     *   OpenGL ES 2.0 / WebGL 1.0.
      */
     class DllExport Shader : public std::enable_shared_from_this<Shader> {
     public:
@@ -317,6 +332,9 @@ namespace sre {
         std::map<std::string,std::string> getCurrentSpecializationConstants();
 
         std::set<std::string> getAllSpecializationConstants();
+
+        bool isInstanced();                                    // True if the shader reads the model transform from
+                                                               // per-instance attributes (S_INSTANCED specialization)
     private:
         std::string precompile(std::string source, std::vector<std::string>& errors, uint32_t shaderType);
         std::string insertPreprocessorDefines(std::string source,
@@ -350,6 +368,19 @@ namespace sre {
         std::map<ShaderType, std::string> shaderSources;
 
         std::shared_ptr<std::vector<Uniform>> uniforms;
+        int materialUniformBlockSize = 0;                       // size of material_uniforms block (0 if not declared)
+        static constexpr int globalUniformBindingIndex = 1;
+        static constexpr int materialUniformBindingIndex = 2;
+        static constexpr int drawUniformBindingIndex = 3;
+        static constexpr int drawUniformBlockDraws = 64;        // draw calls in the bound range of g_draw_uniforms (SI_DRAWS)
+        bool drawUniformBlock = false;                          // true if g_model, g_model_it and g_model_view_it are
+                                                                // read from the g_draw_uniforms block (at g_draw_index)
+
+        Shader* getDepthOnlyShader();                          // variant using the same vertex shader with color writes
+                                                               // disabled and a trivial fragment shader (created on first
+                                                               // use). nullptr if the fragment shader uses discard
+        std::shared_ptr<Shader> depthOnlyShader;
+        bool depthOnlyShaderCreated = false;
 
         struct ShaderAttribute {
             int32_t position;
@@ -375,6 +406,9 @@ namespace sre {
         int uniformLocationLightPosType;
         int uniformLocationLightColorRange;
         int uniformLocationCameraPosition;
+        int uniformLocationDrawIndex;
+        int attributeLocationInstanceModel;
+        int attributeLocationInstanceModelInverseTranspose;
 
     public:
         static std::string translateToGLSLES(std::string source, bool vertexShader, int version = 100);
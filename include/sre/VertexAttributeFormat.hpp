@@ -0,0 +1,28 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    /**
+     * Storage format of a float vertex attribute on the GPU (see Mesh::MeshBuilder::withAttributeFormat()).
+     * The shader still reads the attribute as float/vecN. Normalized formats map the integer range to [0;1] (UNorm)
+     * or [-1;1] (SNorm), and values outside the range are clamped.
+     */
+    enum class VertexAttributeFormat {
+        Float,              // 32 bit float per component (default)
+        Half,               // 16 bit float per component
+        UNorm8,             // 8 bit unsigned normalized per component
+        SNorm8,             // 8 bit signed normalized per component
+        UNorm16,            // 16 bit unsigned normalized per component
+        SNorm16,            // 16 bit signed normalized per component
+        UNorm10_10_10_2,    // vec3/vec4 packed in 32 bit (w uses 2 bits)
+        SNorm10_10_10_2     // vec3/vec4 packed in 32 bit (w uses 2 bits), e.g. for normals and tangents
+    };
+}
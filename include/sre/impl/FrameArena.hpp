@@ -0,0 +1,204 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/Log.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sre {
+    // Linear allocator used for per-frame data (such as render queues).
+    // All allocations are released at once when the arena is reset (in Renderer::swapWindow()). The memory is reused
+    // in the following frames, so a frame with a steady workload does not allocate heap memory.
+    class FrameArena {
+    public:
+        FrameArena() = default;
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        void* allocate(size_t size, size_t alignment);
+        void reset();                                   // Release all allocations. Blocks are merged into a single block
+                                                        // if the last frame needed more than one block
+        uint32_t getGeneration();                       // Incremented each reset
+        size_t getBytesAllocated();                     // Bytes allocated since last reset
+        size_t getCapacity();                           // Total size of blocks
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+        std::vector<Block> blocks;
+        size_t currentBlock = 0;
+        size_t currentOffset = 0;
+        size_t bytesAllocated = 0;
+        uint32_t generation = 0;
+
+        static constexpr size_t minBlockSize = 64*1024;
+    };
+
+    // Growable array stored in a FrameArena (or on the heap if no arena is used).
+    // Storage released by growing is not reused before the arena is reset. Copies always use heap storage, which
+    // allows a copy to outlive the frame.
+    template<typename T>
+    class FrameVector {
+    public:
+        explicit FrameVector(FrameArena* arena = nullptr)
+        :arena(arena)
+        {
+        }
+
+        FrameVector(const FrameVector& other)
+        {
+            reserve(other.count);
+            for (size_t i = 0; i < other.count; i++){
+                new (elements + i) T(other.elements[i]);
+            }
+            count = other.count;
+        }
+
+        FrameVector(FrameVector&& other) noexcept
+        {
+            swap(other);
+        }
+
+        FrameVector& operator=(FrameVector other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~FrameVector(){
+            release();
+        }
+
+        void swap(FrameVector& other) noexcept {
+            std::swap(arena, other.arena);
+            std::swap(generation, other.generation);
+            std::swap(elements, other.elements);
+            std::swap(count, other.count);
+            std::swap(capacity, other.capacity);
+        }
+
+        void reserve(size_t newCapacity){
+            if (newCapacity <= capacity){
+                return;
+            }
+            T* newElements;
+            if (arena){
+                generation = arena->getGeneration();
+                newElements = static_cast<T*>(arena->allocate(sizeof(T) * newCapacity, alignof(T)));
+            } else {
+                newElements = static_cast<T*>(std::malloc(sizeof(T) * newCapacity));
+            }
+            for (size_t i = 0; i < count; i++){
+                new (newElements + i) T(std::move(elements[i]));
+                elements[i].~T();
+            }
+            if (!arena){
+                std::free(elements);
+            }
+            elements = newElements;
+            capacity = newCapacity;
+        }
+
+        void push_back(const T& value){
+            if (count == capacity){
+                T copy(value);              // value may reference an element
+                grow();
+                new (elements + count) T(std::move(copy));
+            } else {
+                new (elements + count) T(value);
+            }
+            count++;
+        }
+
+        void push_back(T&& value){
+            if (count == capacity){
+                T moved(std::move(value));  // value may reference an element
+                grow();
+                new (elements + count) T(std::move(moved));
+            } else {
+                new (elements + count) T(std::move(value));
+            }
+            count++;
+        }
+
+        template<typename... Args>
+        T& emplace_back(Args&&... args){
+            push_back(T{std::forward<Args>(args)...});
+            return back();
+        }
+
+        void resize(size_t newSize, const T& value = T()){
+            while (count > newSize){
+                count--;
+                elements[count].~T();
+            }
+            reserve(newSize);
+            while (count < newSize){
+                new (elements + count) T(value);
+                count++;
+            }
+        }
+
+        void assign(size_t newSize, const T& value){
+            clear();
+            resize(newSize, value);
+        }
+
+        void clear(){
+            resize(0);
+        }
+
+        T& operator[](size_t index) { return elements[index]; }
+        const T& operator[](size_t index) const { return elements[index]; }
+        T& back() { return elements[count - 1]; }
+        T* data() { return elements; }
+        const T* data() const { return elements; }
+        T* begin() { return elements; }
+        T* end() { return elements + count; }
+        const T* begin() const { return elements; }
+        const T* end() const { return elements + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+    private:
+        void grow(){
+            reserve(capacity < 8 ? 16 : capacity * 2);
+        }
+
+        void release(){
+            if (elements == nullptr){
+                return;
+            }
+            if (arena && arena->getGeneration() != generation){
+                // the arena memory has already been released (the owner outlived the frame)
+                if (!std::is_trivially_destructible<T>::value){
+                    LOG_ERROR("FrameVector used after Renderer::swapWindow(). Elements are not destroyed.");
+                }
+                return;
+            }
+            for (size_t i = 0; i < count; i++){
+                elements[i].~T();
+            }
+            if (!arena){
+                std::free(elements);
+            }
+        }
+
+        FrameArena* arena = nullptr;
+        uint32_t generation = 0;
+        T* elements = nullptr;
+        size_t count = 0;
+        size_t capacity = 0;
+    };
+}
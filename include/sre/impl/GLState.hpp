@@ -0,0 +1,87 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/GL.hpp"
+#include <cstdint>
+
+namespace sre {
+    struct RenderStats;
+
+    // Shadows the OpenGL state changed by sre and only issues GL calls when a value changes.
+    // All changes of the tracked state must go through this object (the state is otherwise unknown and must be
+    // invalidated using reset()). ImGui restores the GL state after rendering, so it does not invalidate the cache.
+    class GLState {
+    public:
+        enum class Capability {
+            DepthTest,
+            StencilTest,
+            CullFace,
+            Blend,
+            PolygonOffsetFill,
+            PolygonOffsetLine,                      // Ignored on OpenGL ES
+            PolygonOffsetPoint,                     // Ignored on OpenGL ES
+            ScissorTest,
+            Count
+        };
+
+        explicit GLState(RenderStats* renderStats);
+
+        void reset();                               // Mark all state as unknown (next call of each setter issues a GL call)
+
+        void useProgram(GLuint program);
+        void bindFramebuffer(GLuint framebuffer);   // Binds GL_FRAMEBUFFER
+        void activeTexture(GLuint unit);            // Texture unit index (not GL_TEXTURE0 + unit)
+        void bindTexture(GLuint unit, GLenum target, GLuint texture); // Bind texture to unit (changes the active texture unit
+                                                    // only if the texture is not already bound)
+        void setEnabled(Capability capability, bool enabled);
+        void depthMask(bool enabled);
+        void depthFunc(GLenum func);
+        void colorMask(bool r, bool g, bool b, bool a);
+        void stencilMask(GLuint mask);
+        void stencilFunc(GLenum func, GLint ref, GLuint mask);
+        void stencilOp(GLenum fail, GLenum zfail, GLenum zpass);
+        void blendFunc(GLenum src, GLenum dst);
+        void cullFace(GLenum mode);
+        void polygonOffset(float factor, float units);
+        void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+        void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        void deleteProgram(GLuint program);         // Delete objects (forgetting the binding, since GL names are reused)
+        void deleteFramebuffer(GLuint framebuffer);
+        void deleteTexture(GLuint texture);
+    private:
+        bool changed(bool same);                    // updates counters. Returns true if a GL call must be issued
+
+        RenderStats* renderStats;
+
+        // unknown values are stored as invalid values (such as -1 and NaN) never equal to a requested value
+        GLuint program;
+        GLuint framebuffer;
+        GLuint textureUnit;
+        static constexpr int maxTrackedTextureUnits = 32;    // bindings of higher units are always issued
+        GLenum textureTargets[maxTrackedTextureUnits];       // last texture bound to each unit
+        GLuint textures[maxTrackedTextureUnits];
+        int8_t capabilities[(int)Capability::Count];// 0 disabled, 1 enabled
+        int8_t colorWriteMask;                      // bit 0-3 rgba
+        int8_t depthWrite;
+        GLenum depthFunction;
+        int64_t stencilWriteMask;
+        GLenum stencilFunction;
+        int64_t stencilRef;
+        int64_t stencilFuncMask;
+        GLenum stencilOperations[3];
+        GLenum blendSrc;
+        GLenum blendDst;
+        GLenum cullFaceMode;
+        float polygonOffsetFactor;
+        float polygonOffsetUnits;
+        GLint viewportValue[4];
+        GLint scissorValue[4];
+    };
+}
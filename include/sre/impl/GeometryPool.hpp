@@ -0,0 +1,54 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/Mesh.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/impl/GeometryPoolRanges.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sre {
+    // Vertex and index buffers shared by meshes with the same vertex layout (see Mesh::MeshBuilder::withGeometryPool()).
+    // Each mesh is sub-allocated from the buffers, the vertices are addressed using a base vertex and the indices are
+    // stored as 32-bit values. Meshes of a pool share the vertex array objects (per shader), so switching between them
+    // requires no state changes, and they can be drawn using a single multi draw call.
+    // The buffers grow (copying the content) when full, which invalidates the vertex array objects.
+    class GeometryPool {
+    public:
+        GeometryPool(std::string layout, int bytesPerVertex);
+        ~GeometryPool();
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        void add(Mesh* mesh, const std::vector<float>& interleavedData); // upload the vertices and indices of the mesh
+        void remove(Mesh* mesh);                                        // release the ranges of the mesh
+
+        const std::string& getLayout();
+        size_t getVertexCapacity();
+        size_t getIndexCapacity();
+    private:
+        void grow(GLuint& buffer, RangeAllocator& allocator, size_t elementSize, size_t requiredSize);
+
+        std::string layout;                                             // vertex attributes (see Mesh::getLayoutKey())
+        int bytesPerVertex;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        GeometryPoolRanges ranges;                                      // vertex and index ranges of each mesh
+        std::vector<Mesh*> meshes;
+        std::map<unsigned int, Mesh::VAOBinding> shaderToVertexArrayObject;
+
+        static constexpr size_t minVertexCapacity = 64*1024;
+        static constexpr size_t minIndexCapacity = 256*1024;
+
+        friend class Mesh;
+        friend class RenderPass;
+    };
+}
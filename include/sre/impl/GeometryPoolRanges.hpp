@@ -0,0 +1,38 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/RangeAllocator.hpp"
+#include <cstddef>
+#include <map>
+
+namespace sre {
+    // Vertex and index ranges of the meshes in a GeometryPool. The allocated ranges are recorded per owner (mesh),
+    // so an owner always releases the ranges it was given, even if its vertex or index count changed since.
+    class GeometryPoolRanges {
+    public:
+        struct Range {
+            size_t firstVertex = 0;
+            size_t vertexCount = 0;
+            size_t firstIndex = 0;
+            size_t indexCount = 0;
+        };
+
+        bool allocate(const void* owner, size_t vertexCount,    // Returns false (allocating nothing) if the vertex or
+                      size_t indexCount, Range& range);         // index capacity has no free range large enough
+        void free(const void* owner);                           // Release the ranges allocated by owner
+        bool contains(const void* owner);
+
+        RangeAllocator& getVertices();                          // ranges in vertices
+        RangeAllocator& getIndices();                           // ranges in (32-bit) indices
+    private:
+        RangeAllocator vertices;
+        RangeAllocator indices;
+        std::map<const void*, Range> ranges;
+    };
+}
@@ -0,0 +1,20 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include <cstddef>
+
+namespace sre {
+    // Computes the normal matrices transpose(inverse(mat3(model))) of count model transforms.
+    // modelStride is the distance in bytes between the model transforms (allowing the transforms to be read directly
+    // from an array of structs). The transforms are processed in batches stored as structure of arrays, allowing the
+    // loops to be vectorized. Batches of rigid and uniformly scaled transforms skip the inverse. Singular transforms
+    // give a zero matrix.
+    void computeNormalMatrices(const glm::mat4* models, size_t modelStride, glm::mat3* normalMatrices, size_t count);
+}
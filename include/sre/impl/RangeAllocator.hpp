@@ -0,0 +1,34 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <map>
+
+namespace sre {
+    // First-fit allocator of ranges within [0;capacity) (such as ranges of a GPU buffer). Freed ranges are merged
+    // with adjacent free ranges. The allocator does not own any memory.
+    class RangeAllocator {
+    public:
+        static constexpr size_t invalid = std::numeric_limits<size_t>::max();
+
+        explicit RangeAllocator(size_t capacity = 0);
+
+        size_t allocate(size_t size);                   // Returns the offset of the range (or invalid if no free range
+                                                        // is large enough). Empty ranges get offset 0
+        void free(size_t offset, size_t size);          // Release a range returned by allocate()
+        void grow(size_t capacity);                     // Extend the capacity (the new space is free)
+        size_t getCapacity();
+        size_t getFreeSize();                           // Total size of free ranges
+        size_t getLargestFreeRange();
+    private:
+        std::map<size_t, size_t> freeRanges;            // offset to size
+        size_t capacity = 0;
+    };
+}
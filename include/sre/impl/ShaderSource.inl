@@ -1,5 +1,5 @@
 // autogenerated by
-// files_to_cpp shader src/embedded_deps/shadow_frag.glsl shadow_frag.glsl src/embedded_deps/shadow_vert.glsl shadow_vert.glsl src/embedded_deps/skybox_proc_frag.glsl skybox_proc_frag.glsl src/embedded_deps/skybox_proc_vert.glsl skybox_proc_vert.glsl src/embedded_deps/skybox_frag.glsl skybox_frag.glsl src/embedded_deps/skybox_vert.glsl skybox_vert.glsl src/embedded_deps/sre_utils_incl.glsl sre_utils_incl.glsl src/embedded_deps/debug_normal_frag.glsl debug_normal_frag.glsl src/embedded_deps/debug_normal_vert.glsl debug_normal_vert.glsl src/embedded_deps/debug_uv_frag.glsl debug_uv_frag.glsl src/embedded_deps/debug_uv_vert.glsl debug_uv_vert.glsl src/embedded_deps/light_incl.glsl light_incl.glsl src/embedded_deps/particles_frag.glsl particles_frag.glsl src/embedded_deps/particles_vert.glsl particles_vert.glsl src/embedded_deps/sprite_frag.glsl sprite_frag.glsl src/embedded_deps/sprite_vert.glsl sprite_vert.glsl src/embedded_deps/standard_pbr_frag.glsl standard_pbr_frag.glsl src/embedded_deps/standard_pbr_vert.glsl standard_pbr_vert.glsl src/embedded_deps/standard_blinn_phong_frag.glsl standard_blinn_phong_frag.glsl src/embedded_deps/standard_blinn_phong_vert.glsl standard_blinn_phong_vert.glsl src/embedded_deps/standard_phong_frag.glsl standard_phong_frag.glsl src/embedded_deps/standard_phong_vert.glsl standard_phong_vert.glsl src/embedded_deps/blit_frag.glsl blit_frag.glsl src/embedded_deps/blit_vert.glsl blit_vert.glsl src/embedded_deps/unlit_frag.glsl unlit_frag.glsl src/embedded_deps/unlit_vert.glsl unlit_vert.glsl src/embedded_deps/debug_tangent_frag.glsl debug_tangent_frag.glsl src/embedded_deps/debug_tangent_vert.glsl debug_tangent_vert.glsl src/embedded_deps/normalmap_incl.glsl normalmap_incl.glsl src/embedded_deps/global_uniforms_incl.glsl global_uniforms_incl.glsl include/sre/impl/ShaderSource.inl
+// files_to_cpp shader src/embedded_deps/shadow_frag.glsl shadow_frag.glsl src/embedded_deps/shadow_vert.glsl shadow_vert.glsl src/embedded_deps/skybox_proc_frag.glsl skybox_proc_frag.glsl src/embedded_deps/skybox_proc_vert.glsl skybox_proc_vert.glsl src/embedded_deps/skybox_frag.glsl skybox_frag.glsl src/embedded_deps/skybox_vert.glsl skybox_vert.glsl src/embedded_deps/sre_utils_incl.glsl sre_utils_incl.glsl src/embedded_deps/debug_normal_frag.glsl debug_normal_frag.glsl src/embedded_deps/debug_normal_vert.glsl debug_normal_vert.glsl src/embedded_deps/debug_uv_frag.glsl debug_uv_frag.glsl src/embedded_deps/debug_uv_vert.glsl debug_uv_vert.glsl src/embedded_deps/light_incl.glsl light_incl.glsl src/embedded_deps/particles_frag.glsl particles_frag.glsl src/embedded_deps/particles_vert.glsl particles_vert.glsl src/embedded_deps/sprite_frag.glsl sprite_frag.glsl src/embedded_deps/sprite_vert.glsl sprite_vert.glsl src/embedded_deps/standard_pbr_frag.glsl standard_pbr_frag.glsl src/embedded_deps/standard_pbr_vert.glsl standard_pbr_vert.glsl src/embedded_deps/standard_blinn_phong_frag.glsl standard_blinn_phong_frag.glsl src/embedded_deps/standard_blinn_phong_vert.glsl standard_blinn_phong_vert.glsl src/embedded_deps/standard_phong_frag.glsl standard_phong_frag.glsl src/embedded_deps/standard_phong_vert.glsl standard_phong_vert.glsl src/embedded_deps/blit_frag.glsl blit_frag.glsl src/embedded_deps/blit_vert.glsl blit_vert.glsl src/embedded_deps/unlit_frag.glsl unlit_frag.glsl src/embedded_deps/unlit_vert.glsl unlit_vert.glsl src/embedded_deps/debug_tangent_frag.glsl debug_tangent_frag.glsl src/embedded_deps/debug_tangent_vert.glsl debug_tangent_vert.glsl src/embedded_deps/normalmap_incl.glsl normalmap_incl.glsl src/embedded_deps/global_uniforms_incl.glsl global_uniforms_incl.glsl src/embedded_deps/depth_only_frag.glsl depth_only_frag.glsl src/embedded_deps/occlusion_box_vert.glsl occlusion_box_vert.glsl include/sre/impl/ShaderSource.inl
 #include <map>
 #include <utility>
 #include <string>
@@ -431,8 +431,24 @@ in vec3 vNormal;
 in vec2 vUV;
 in vec3 vWsPos;
 
+// Per material uniforms
+#if __VERSION__ > 100
+layout(std140) uniform material_uniforms {
+#endif
 uniform vec4 color;
 uniform vec4 metallicRoughness;
+#ifdef S_NORMALMAP
+uniform float normalScale;
+#endif
+#ifdef S_EMISSIVEMAP
+uniform vec4 emissiveFactor;
+#endif
+#ifdef S_OCCLUSIONMAP
+uniform float occlusionStrength;
+#endif
+#if __VERSION__ > 100
+};
+#endif
 
 uniform sampler2D tex;
 #ifdef S_METALROUGHNESSMAP
@@ -440,15 +456,12 @@ uniform sampler2D mrTex;
 #endif
 #ifdef S_NORMALMAP
 uniform sampler2D normalTex;
-uniform float normalScale;
 #endif
 #ifdef S_EMISSIVEMAP
 uniform sampler2D emissiveTex;
-uniform vec4 emissiveFactor;
 #endif
 #ifdef S_OCCLUSIONMAP
 uniform sampler2D occlusionTex;
-uniform float occlusionStrength;
 #endif
 #ifdef S_VERTEX_COLOR
 in vec4 vColor;
@@ -974,7 +987,51 @@ uniform vec4 g_lightPosType[SI_LIGHTS];
 #endif
 
 // per draw call uniforms
+#if defined(S_INSTANCED) && defined(SI_VERTEX) && __VERSION__ > 100
+// per instance attributes (set by the engine when drawing instanced)
+in mat4 g_instance_model;
+in mat3 g_instance_model_it;
+#define g_model g_instance_model
+#define g_model_it g_instance_model_it
+#define g_model_view_it (mat3(g_view) * g_instance_model_it)
+#elif !defined(S_INSTANCED) && __VERSION__ > 100
+// per draw call data (written for all draw calls of a render pass at once). The engine binds the range of
+// SI_DRAWS draw calls containing the current draw call, which is selected using g_draw_index
+struct g_draw {
+    mat4 model;
+    mat3 model_it;
+    mat3 model_view_it;
+};
+layout(std140) uniform g_draw_uniforms {
+    g_draw g_draws[SI_DRAWS];
+};
+uniform int g_draw_index;
+#define g_model g_draws[g_draw_index].model
+#define g_model_it g_draws[g_draw_index].model_it
+#define g_model_view_it g_draws[g_draw_index].model_view_it
+#else
 uniform mat4 g_model;
 uniform mat3 g_model_it;
-uniform mat3 g_model_view_it;)"),
+uniform mat3 g_model_view_it;
+#endif)"),
+std::make_pair<std::string,std::string>("depth_only_frag.glsl",R"(#version 330
+out vec4 fragColor;
+
+// fragment shader of depth-only shader variants (used by the depth pre-pass)
+void main(void)
+{
+    fragColor = vec4(0.0);
+})"),
+std::make_pair<std::string,std::string>("occlusion_box_vert.glsl",R"(#version 330
+in vec3 position;
+
+uniform mat4 boxTransform;
+
+#pragma include "global_uniforms_incl.glsl"
+
+// vertex shader of the bounding boxes drawn by occlusion queries (the box transform maps the cube [-1;1] to the mesh
+// bounds in world space)
+void main(void) {
+    gl_Position = g_projection * g_view * boxTransform * vec4(position,1.0);
+})"),
 };
\ No newline at end of file
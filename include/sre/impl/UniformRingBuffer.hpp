@@ -0,0 +1,34 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/GL.hpp"
+#include <cstddef>
+
+namespace sre {
+    // Uniform buffer streamed by the render passes of a frame. The buffer has a segment per frame in flight, guarded
+    // by a fence, so data is written unsynchronized into storage the GPU no longer reads (instead of orphaning the
+    // buffer or waiting for the draw calls of the previous frames).
+    class UniformRingBuffer {
+    public:
+        void init(size_t segmentSize, size_t alignment);    // create the buffer (segmentSize is the initial size per frame)
+        void release();                                     // delete the buffer and fences (while the GL context exists)
+
+        size_t write(const void* data, size_t size, int frame);// append data to the segment of the frame. Returns the
+                                                            // offset (a multiple of the alignment). Grows when full
+        void fence(int frame);                              // fence the segment written this frame (called in swapWindow())
+        GLuint getBuffer();                                 // 0 if not initialized (uniform buffers not supported)
+    private:
+        static constexpr int segments = 3;
+        GLuint buffer = 0;
+        size_t segmentSize = 0;
+        size_t segmentOffset = 0;                           // next free position in the segment of this frame
+        size_t alignment = 256;                             // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+        GLsync fences[segments] = {};
+    };
+}
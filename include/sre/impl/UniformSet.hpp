@@ -24,6 +24,8 @@ namespace sre {
 
         void set(int id, std::shared_ptr<Texture> value);
 
+        void setTextureUnit(int id, int unit);                      // texture unit of sampler uniform (see Uniform::textureUnit)
+
         void set(int id, std::shared_ptr<std::vector<glm::mat3>> value);
 
         void set(int id, std::shared_ptr<std::vector<glm::mat4>> value);
@@ -37,7 +39,11 @@ namespace sre {
         template<typename T>
         inline T get(int id);
     private:
-        std::map<int,std::shared_ptr<sre::Texture>> textureValues;
+        struct TextureValue {
+            std::shared_ptr<sre::Texture> texture;
+            int unit = -1;
+        };
+        std::map<int,TextureValue> textureValues;
         std::map<int,glm::vec4> vectorValues;
         std::map<int,glm::mat4> mat4Values;
         std::map<int,std::shared_ptr<std::vector<glm::mat4>>> mat4sValues;
@@ -49,7 +55,7 @@ namespace sre {
 
     template<>
     inline std::shared_ptr<sre::Texture> UniformSet::get(int id) {
-        return textureValues[id];
+        return textureValues[id].texture;
     }
 
     template<>
@@ -0,0 +1,22 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/VertexAttributeFormat.hpp"
+#include <cstdint>
+
+namespace sre {
+    // Size in bytes of a vertex attribute with the given number of components (padded to a multiple of 4 bytes)
+    int vertexAttributeBytes(VertexAttributeFormat format, int components);
+
+    // Converts the components of a vertex attribute to the format (writing vertexAttributeBytes() bytes to dest).
+    // The packed 10_10_10_2 formats expect 3 or 4 components (w is 0 for 3 components).
+    void packVertexAttribute(VertexAttributeFormat format, const float* values, int components, void* dest);
+
+    uint16_t floatToHalf(float value);                  // IEEE 754 half precision (rounded to nearest even)
+}
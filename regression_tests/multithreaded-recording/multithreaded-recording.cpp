@@ -0,0 +1,150 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/euler_angles.hpp>
+#include <glm/gtx/transform.hpp>
+
+// Renders the same scene using serial recording (RenderPass::draw) and parallel recording (RenderPass::createRecorder)
+// and verifies that the resulting images are identical. The time used for recording is measured for 1..N threads.
+// The program returns 0 if all images match.
+
+constexpr int GRID_DIM = 48;
+
+using namespace sre;
+
+class MultithreadedRecordingTest {
+public:
+    MultithreadedRecordingTest() {
+        r.init();
+
+        camera.lookAt({0,0,GRID_DIM*1.2f},{0,0,0},{0,1,0});
+        camera.setPerspectiveProjection(60,0.1,200);
+        worldLights.addLight(Light::create().withDirectionalLight(glm::vec3(1,1,1)).withColor(Color(1,1,1),1).build());
+
+        meshes = {
+                Mesh::create().withCube(0.3f).build(),
+                Mesh::create().withSphere(8,8,0.3f).build(),
+        };
+        materials = {
+                Shader::getStandardBlinnPhong()->createMaterial(),
+                Shader::getUnlit()->createMaterial(),
+        };
+        materials[0]->setColor({1,0,0,1});
+        materials[1]->setColor({0,1,0,1});
+
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        r.frameRender = [&](){
+            render();
+        };
+        r.startEventLoop();
+    }
+
+    // object transform is computed while recording (as the application would do)
+    void record(int first, int last, const std::function<void(std::shared_ptr<Mesh>&, glm::mat4, std::shared_ptr<Material>&)>& draw){
+        float offset = -(GRID_DIM / 2.0f);
+        for (int index = first; index < last; index++){
+            int i = index % GRID_DIM;
+            int j = (index / GRID_DIM) % GRID_DIM;
+            int k = index / (GRID_DIM * GRID_DIM);
+            glm::mat4 transform = glm::translate(glm::vec3(i + offset, j + offset, -k)) *
+                                  glm::eulerAngleYXZ(index * 0.1f, index * 0.2f, index * 0.3f);
+            draw(meshes[index % meshes.size()], transform, materials[(index / 3) % materials.size()]);
+        }
+    }
+
+    RenderPass createRenderPass(){
+        return RenderPass::create()
+                .withCamera(camera)
+                .withWorldLights(&worldLights)
+                .withClearColor(true, {0, 0, 0, 1})
+                .withGUI(false)
+                .build();
+    }
+
+    // returns record time in ms
+    double renderSerial(std::vector<glm::u8vec4>& pixels){
+        auto renderPass = createRenderPass();
+        auto start = std::chrono::high_resolution_clock::now();
+        record(0, objectCount, [&](std::shared_ptr<Mesh>& mesh, glm::mat4 transform, std::shared_ptr<Material>& material){
+            renderPass.draw(mesh, transform, material);
+        });
+        auto end = std::chrono::high_resolution_clock::now();
+        renderPass.finish();
+        pixels = renderPass.readRawPixels(0, 0, size.x, size.y);
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    double renderParallel(int threadCount, std::vector<glm::u8vec4>& pixels){
+        auto renderPass = createRenderPass();
+        std::vector<std::shared_ptr<RenderPass::Recorder>> recorders;
+        for (int t = 0; t < threadCount; t++){
+            recorders.push_back(renderPass.createRecorder());
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; t++){
+            int first = objectCount * t / threadCount;
+            int last = objectCount * (t + 1) / threadCount;
+            auto recorder = recorders[t];
+            threads.emplace_back([this, first, last, recorder](){
+                record(first, last, [&](std::shared_ptr<Mesh>& mesh, glm::mat4 transform, std::shared_ptr<Material>& material){
+                    recorder->draw(mesh, transform, material);
+                });
+            });
+        }
+        for (auto& thread : threads){
+            thread.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        renderPass.finish();
+        pixels = renderPass.readRawPixels(0, 0, size.x, size.y);
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void render(){
+        size = r.getDrawableSize();
+        std::vector<glm::u8vec4> serialPixels;
+        std::vector<glm::u8vec4> parallelPixels;
+        double serialTime = renderSerial(serialPixels);
+        std::cout << "Recording " << objectCount << " objects" << std::endl;
+        std::cout << "Serial: " << serialTime << " ms" << std::endl;
+        for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2){
+            double time = renderParallel(threadCount, parallelPixels);
+            bool equal = serialPixels == parallelPixels;
+            std::cout << "Threads: " << threadCount << " " << time << " ms speedup " << (serialTime / time)
+                      << (equal ? " (image equal)" : " (IMAGE DIFFERS)") << std::endl;
+            if (!equal){
+                failed = true;
+            }
+        }
+        r.stopEventLoop();
+    }
+
+    bool hasFailed(){
+        return failed;
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    WorldLights worldLights;
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::shared_ptr<Material>> materials;
+    glm::ivec2 size;
+    int objectCount = GRID_DIM * GRID_DIM * GRID_DIM;
+    int maxThreads;
+    bool failed = false;
+};
+
+int main() {
+    MultithreadedRecordingTest test;
+    return test.hasFailed() ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#version 330
+out vec4 fragColor;
+
+// fragment shader of depth-only shader variants (used by the depth pre-pass)
+void main(void)
+{
+    fragColor = vec4(0.0);
+}
\ No newline at end of file
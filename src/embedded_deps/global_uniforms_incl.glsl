@@ -15,6 +15,30 @@ uniform vec4 g_lightPosType[SI_LIGHTS];
 #endif
 
 // per draw call uniforms
+#if defined(S_INSTANCED) && defined(SI_VERTEX) && __VERSION__ > 100
+// per instance attributes (set by the engine when drawing instanced)
+in mat4 g_instance_model;
+in mat3 g_instance_model_it;
+#define g_model g_instance_model
+#define g_model_it g_instance_model_it
+#define g_model_view_it (mat3(g_view) * g_instance_model_it)
+#elif !defined(S_INSTANCED) && __VERSION__ > 100
+// per draw call data (written for all draw calls of a render pass at once). The engine binds the range of
+// SI_DRAWS draw calls containing the current draw call, which is selected using g_draw_index
+struct g_draw {
+    mat4 model;
+    mat3 model_it;
+    mat3 model_view_it;
+};
+layout(std140) uniform g_draw_uniforms {
+    g_draw g_draws[SI_DRAWS];
+};
+uniform int g_draw_index;
+#define g_model g_draws[g_draw_index].model
+#define g_model_it g_draws[g_draw_index].model_it
+#define g_model_view_it g_draws[g_draw_index].model_view_it
+#else
 uniform mat4 g_model;
 uniform mat3 g_model_it;
 uniform mat3 g_model_view_it;
+#endif
@@ -0,0 +1,12 @@
+#version 330
+in vec3 position;
+
+uniform mat4 boxTransform;
+
+#pragma include "global_uniforms_incl.glsl"
+
+// vertex shader of the bounding boxes drawn by occlusion queries (the box transform maps the cube [-1;1] to the mesh
+// bounds in world space)
+void main(void) {
+    gl_Position = g_projection * g_view * boxTransform * vec4(position,1.0);
+}
\ No newline at end of file
@@ -10,8 +10,24 @@ in vec3 vNormal;
 in vec2 vUV;
 in vec3 vWsPos;
 
+// Per material uniforms
+#if __VERSION__ > 100
+layout(std140) uniform material_uniforms {
+#endif
 uniform vec4 color;
 uniform vec4 metallicRoughness;
+#ifdef S_NORMALMAP
+uniform float normalScale;
+#endif
+#ifdef S_EMISSIVEMAP
+uniform vec4 emissiveFactor;
+#endif
+#ifdef S_OCCLUSIONMAP
+uniform float occlusionStrength;
+#endif
+#if __VERSION__ > 100
+};
+#endif
 
 uniform sampler2D tex;
 #ifdef S_METALROUGHNESSMAP
@@ -19,15 +35,12 @@ uniform sampler2D mrTex;
 #endif
 #ifdef S_NORMALMAP
 uniform sampler2D normalTex;
-uniform float normalScale;
 #endif
 #ifdef S_EMISSIVEMAP
 uniform sampler2D emissiveTex;
-uniform vec4 emissiveFactor;
 #endif
 #ifdef S_OCCLUSIONMAP
 uniform sampler2D occlusionTex;
-uniform float occlusionStrength;
 #endif
 #ifdef S_VERTEX_COLOR
 in vec4 vColor;
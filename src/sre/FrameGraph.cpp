@@ -0,0 +1,353 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/FrameGraph.hpp"
+#include "sre/Framebuffer.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+#include <algorithm>
+#include <set>
+
+namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        bool isInvalidateFramebufferSupported(){
+            auto& info = renderInfo();
+            if (info.graphicsAPIVersionES){
+                return info.graphicsAPIVersionMajor >= 3;
+            }
+            return info.graphicsAPIVersionMajor > 4 || (info.graphicsAPIVersionMajor == 4 && info.graphicsAPIVersionMinor >= 3);
+        }
+
+        void addUnique(std::vector<int>& list, int value){
+            if (std::find(list.begin(), list.end(), value) == list.end()){
+                list.push_back(value);
+            }
+        }
+    }
+
+    bool FrameGraph::TextureDescription::operator==(const FrameGraph::TextureDescription& other) const {
+        return size == other.size && depth == other.depth && depthPrecision == other.depthPrecision &&
+               filterSampling == other.filterSampling && wrap == other.wrap;
+    }
+
+    FrameGraph::PassBuilder::PassBuilder(FrameGraph* frameGraph, int pass)
+    :frameGraph(frameGraph), pass(pass)
+    {
+    }
+
+    FrameGraph::Resource FrameGraph::PassBuilder::createTexture(const std::string& name, const TextureDescription& description) {
+        Resource resource = (Resource)frameGraph->resources.size();
+        frameGraph->resources.emplace_back();
+        frameGraph->resources.back().name = name;
+        frameGraph->resources.back().description = description;
+        return write(resource);
+    }
+
+    FrameGraph::Resource FrameGraph::PassBuilder::read(Resource resource) {
+        LOG_ASSERT(resource >= 0 && resource < (Resource)frameGraph->resources.size() && "Invalid frame graph resource");
+        addUnique(frameGraph->passes[pass].reads, resource);
+        addUnique(frameGraph->resources[resource].readers, pass);
+        return resource;
+    }
+
+    FrameGraph::Resource FrameGraph::PassBuilder::write(Resource resource) {
+        LOG_ASSERT(resource >= 0 && resource < (Resource)frameGraph->resources.size() && "Invalid frame graph resource");
+        addUnique(frameGraph->passes[pass].writes, resource);
+        addUnique(frameGraph->resources[resource].writers, pass);
+        return resource;
+    }
+
+    void FrameGraph::PassBuilder::writeScreen() {
+        frameGraph->passes[pass].writesScreen = true;
+    }
+
+    FrameGraph::PassContext::PassContext(FrameGraph* frameGraph, int pass, std::shared_ptr<Framebuffer> framebuffer)
+    :frameGraph(frameGraph), pass(pass), framebuffer(std::move(framebuffer))
+    {
+    }
+
+    std::shared_ptr<Framebuffer> FrameGraph::PassContext::getFramebuffer() {
+        return framebuffer;
+    }
+
+    std::shared_ptr<Texture> FrameGraph::PassContext::getTexture(Resource resource) {
+        auto& passNode = frameGraph->passes[pass];
+        if (std::find(passNode.reads.begin(), passNode.reads.end(), resource) == passNode.reads.end() &&
+            std::find(passNode.writes.begin(), passNode.writes.end(), resource) == passNode.writes.end()){
+            LOG_ERROR("Frame graph pass %s does not declare the texture %s", passNode.name.c_str(),
+                      resource >= 0 && resource < (Resource)frameGraph->resources.size() ? frameGraph->resources[resource].name.c_str() : "(invalid)");
+            return nullptr;
+        }
+        return frameGraph->resources[resource].texture;
+    }
+
+    FrameGraph::Resource FrameGraph::importTexture(const std::string& name, std::shared_ptr<Texture> texture) {
+        LOG_ASSERT(texture && "importTexture() expects a texture");
+        ResourceNode resource;
+        resource.name = name;
+        resource.description.size = {texture->getWidth(), texture->getHeight()};
+        resource.description.depth = texture->isDepthTexture();
+        resource.description.depthPrecision = texture->getDepthPrecision();
+        resource.description.filterSampling = texture->isFilterSampling();
+        resource.description.wrap = texture->getWrapUV();
+        resource.imported = std::move(texture);
+        resources.push_back(resource);
+        return (Resource)resources.size() - 1;
+    }
+
+    void FrameGraph::addPass(const std::string& name, std::function<void(PassBuilder&)> setup, std::function<void(PassContext&)> execute) {
+        passes.emplace_back();
+        passes.back().name = name;
+        passes.back().execute = std::move(execute);
+        PassBuilder builder(this, (int)passes.size() - 1);
+        setup(builder);
+    }
+
+    void FrameGraph::cullPasses() {
+        // passes are kept if they write to the screen or an imported texture, or write a texture read by a kept pass
+        std::vector<int> stack;
+        for (int i = 0; i < (int)passes.size(); i++){
+            bool output = passes[i].writesScreen;
+            for (auto resource : passes[i].writes){
+                output |= resources[resource].imported != nullptr;
+            }
+            passes[i].culled = !output;
+            if (output){
+                stack.push_back(i);
+            }
+        }
+        while (!stack.empty()){
+            int pass = stack.back();
+            stack.pop_back();
+            for (auto resource : passes[pass].reads){
+                for (auto writer : resources[resource].writers){
+                    if (passes[writer].culled){
+                        passes[writer].culled = false;
+                        stack.push_back(writer);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<int> FrameGraph::sortPasses() {
+        // a pass runs after the writers of the textures it reads, and writers of a texture run in declaration order
+        std::vector<std::vector<int>> edges(passes.size());
+        std::vector<int> incoming(passes.size(), 0);
+        auto addEdge = [&](int from, int to){
+            if (from != to && !passes[from].culled && !passes[to].culled &&
+                std::find(edges[from].begin(), edges[from].end(), to) == edges[from].end()){
+                edges[from].push_back(to);
+                incoming[to]++;
+            }
+        };
+        for (auto& resource : resources){
+            for (size_t i = 1; i < resource.writers.size(); i++){
+                addEdge(resource.writers[i - 1], resource.writers[i]);
+            }
+            for (auto reader : resource.readers){
+                for (auto writer : resource.writers){
+                    addEdge(writer, reader);
+                }
+            }
+        }
+        std::set<int> ready;                                    // ordered by declaration (keeps independent passes in order)
+        for (int i = 0; i < (int)passes.size(); i++){
+            if (!passes[i].culled && incoming[i] == 0){
+                ready.insert(i);
+            }
+        }
+        std::vector<int> order;
+        while (!ready.empty()){
+            int pass = *ready.begin();
+            ready.erase(ready.begin());
+            order.push_back(pass);
+            for (auto next : edges[pass]){
+                if (--incoming[next] == 0){
+                    ready.insert(next);
+                }
+            }
+        }
+        size_t kept = std::count_if(passes.begin(), passes.end(), [](const PassNode& pass){ return !pass.culled; });
+        if (order.size() != kept){
+            LOG_ERROR("Frame graph has cyclic dependencies. Executing passes in declaration order.");
+            order.clear();
+            for (int i = 0; i < (int)passes.size(); i++){
+                if (!passes[i].culled){
+                    order.push_back(i);
+                }
+            }
+        }
+        return order;
+    }
+
+    void FrameGraph::acquireTexture(ResourceNode& resource, std::vector<bool>& poolInUse) {
+        auto renderer = Renderer::instance;
+        auto& pool = renderer->transientTextures;
+        for (size_t i = 0; i < pool.size(); i++){
+            if (!poolInUse[i] && pool[i].description == resource.description){
+                poolInUse[i] = true;
+                pool[i].lastFrame = renderer->renderStats.frame;
+                resource.poolIndex = (int)i;
+                resource.texture = pool[i].texture;
+                return;
+            }
+        }
+        auto& description = resource.description;
+        auto builder = Texture::create();
+        builder.withName(resource.name)
+               .withGenerateMipmaps(false)
+               .withFilterSampling(description.filterSampling)
+               .withWrapUV(description.wrap);
+        if (description.depth){
+            builder.withDepth(description.size.x, description.size.y, description.depthPrecision);
+        } else {
+            builder.withRGBAData(nullptr, description.size.x, description.size.y);
+        }
+        pool.push_back({description, builder.build(), renderer->renderStats.frame});
+        poolInUse.push_back(true);
+        resource.poolIndex = (int)pool.size() - 1;
+        resource.texture = pool.back().texture;
+    }
+
+    std::shared_ptr<Framebuffer> FrameGraph::getFramebuffer(int pass) {
+        auto& passNode = passes[pass];
+        if (passNode.writes.empty()){
+            return nullptr;
+        }
+        std::vector<Texture*> key;                              // color attachments followed by the depth attachment
+        std::shared_ptr<Texture> depthTexture;
+        for (auto resource : passNode.writes){
+            auto& texture = resources[resource].texture;
+            if (texture->isDepthTexture()){
+                depthTexture = texture;
+            } else {
+                key.push_back(texture.get());
+            }
+        }
+        key.push_back(depthTexture.get());
+
+        auto renderer = Renderer::instance;
+        auto& cached = renderer->transientFramebuffers[key];
+        if (!cached.framebuffer){
+            auto builder = Framebuffer::create();
+            builder.withName(passNode.name);
+            for (auto resource : passNode.writes){
+                auto& texture = resources[resource].texture;
+                if (!texture->isDepthTexture()){
+                    builder.withColorTexture(texture);
+                }
+            }
+            if (depthTexture){
+                builder.withDepthTexture(depthTexture);
+            }
+            cached.framebuffer = builder.build();
+        }
+        cached.lastFrame = renderer->renderStats.frame;
+        return cached.framebuffer;
+    }
+
+    void FrameGraph::invalidate(ResourceNode& resource) {
+        auto& framebuffer = resource.lastFramebuffer;
+        if (!framebuffer || !isInvalidateFramebufferSupported()){
+            return;
+        }
+        GLenum attachment = GL_DEPTH_ATTACHMENT;
+        if (!resource.description.depth){
+            auto& textures = framebuffer->textures;
+            auto it = std::find(textures.begin(), textures.end(), resource.texture);
+            if (it == textures.end()){
+                return;
+            }
+            attachment = GL_COLOR_ATTACHMENT0 + (GLenum)(it - textures.begin());
+        }
+        // the content is not needed after the last use (saves storing the attachment on tiled GPUs)
+        auto& glState = Renderer::instance->glState;
+        glState.bindFramebuffer(framebuffer->frameBufferObjectId);
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, &attachment);
+        glState.bindFramebuffer(0);
+    }
+
+    std::vector<std::string> FrameGraph::getPassOrder() {
+        cullPasses();
+        std::vector<std::string> names;
+        for (auto pass : sortPasses()){
+            names.push_back(passes[pass].name);
+        }
+        return names;
+    }
+
+    void FrameGraph::execute() {
+        if (executed){
+            LOG_ERROR("FrameGraph::execute() called twice. Build a new frame graph each frame.");
+            return;
+        }
+        executed = true;
+        executedPasses.clear();
+        cullPasses();
+        auto order = sortPasses();
+
+        // lifetime of the textures (as positions in the execution order)
+        for (int position = 0; position < (int)order.size(); position++){
+            auto& passNode = passes[order[position]];
+            for (auto& list : {passNode.reads, passNode.writes}){
+                for (auto resource : list){
+                    auto& resourceNode = resources[resource];
+                    if (resourceNode.firstUse == -1){
+                        resourceNode.firstUse = position;
+                    }
+                    resourceNode.lastUse = position;
+                }
+            }
+        }
+
+        std::vector<bool> poolInUse(Renderer::instance->transientTextures.size(), false);
+        for (int position = 0; position < (int)order.size(); position++){
+            int pass = order[position];
+            auto& passNode = passes[pass];
+            for (auto& list : {passNode.reads, passNode.writes}){
+                for (auto resource : list){
+                    auto& resourceNode = resources[resource];
+                    if (resourceNode.texture){
+                        continue;
+                    }
+                    if (resourceNode.imported){
+                        resourceNode.texture = resourceNode.imported;
+                    } else {
+                        acquireTexture(resourceNode, poolInUse);
+                    }
+                }
+            }
+
+            auto framebuffer = getFramebuffer(pass);
+            PassContext context(this, pass, framebuffer);
+            passNode.execute(context);
+            executedPasses.push_back(passNode.name);
+            for (auto resource : passNode.writes){
+                resources[resource].lastFramebuffer = framebuffer;
+            }
+
+            // transient textures no longer used are invalidated and may be aliased by the following passes
+            for (auto& list : {passNode.reads, passNode.writes}){
+                for (auto resource : list){
+                    auto& resourceNode = resources[resource];
+                    if (resourceNode.lastUse == position && resourceNode.poolIndex != -1){
+                        invalidate(resourceNode);
+                        poolInUse[resourceNode.poolIndex] = false;
+                        resourceNode.poolIndex = -1;
+                    }
+                }
+            }
+        }
+    }
+
+    const std::vector<std::string>& FrameGraph::getExecutedPasses() {
+        return executedPasses;
+    }
+}
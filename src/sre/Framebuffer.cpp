@@ -72,7 +72,7 @@ namespace sre{
             if (renderbuffer != 0){
                 glDeleteRenderbuffers(1, &renderbuffer);
             }
-            glDeleteFramebuffers(1,&frameBufferObjectId);
+            r->glState.deleteFramebuffer(frameBufferObjectId);
         }
     }
 
@@ -124,7 +124,7 @@ namespace sre{
 
 
     void Framebuffer::bind() {
-        glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObjectId);
+        Renderer::instance->glState.bindFramebuffer(frameBufferObjectId);
         if (dirty){
             
             if (screenTextureId)
@@ -200,7 +200,7 @@ namespace sre{
         GLsizei msaa = 4;
         glEnable(GL_MULTISAMPLE);
         glGenFramebuffers(1, &(framebuffer->frameBufferObjectId));
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->frameBufferObjectId);
+        Renderer::instance->glState.bindFramebuffer(framebuffer->frameBufferObjectId);
 
         std::vector<GLenum> drawBuffers;
         if (screenTextureId)
@@ -271,7 +271,7 @@ namespace sre{
         checkStatus();
         framebuffer->textures = textures;
         framebuffer->depthTexture = depthTexture;
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Renderer::instance->glState.bindFramebuffer(0);
 
         return std::shared_ptr<Framebuffer>(framebuffer);
     }
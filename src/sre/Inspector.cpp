@@ -93,6 +93,27 @@ namespace sre {
                 case GL_INT_VEC4:
                     typeStr = "ivec4";
                     break;
+                case GL_HALF_FLOAT:
+                    typeStr = "half";
+                    break;
+                case GL_BYTE:
+                    typeStr = "byte";
+                    break;
+                case GL_UNSIGNED_BYTE:
+                    typeStr = "ubyte";
+                    break;
+                case GL_SHORT:
+                    typeStr = "short";
+                    break;
+                case GL_UNSIGNED_SHORT:
+                    typeStr = "ushort";
+                    break;
+                case GL_INT_2_10_10_10_REV:
+                    typeStr = "int_2_10_10_10";
+                    break;
+                case GL_UNSIGNED_INT_2_10_10_10_REV:
+                    typeStr = "uint_2_10_10_10";
+                    break;
                 default:
                     typeStr = "invalid";
             }
@@ -105,6 +126,7 @@ namespace sre {
     {
         stats.resize(frames);
         millisecondsFrameTime.resize(frames);
+        millisecondsGpu.resize(frames);
         if (SDLRenderer::instance){
             millisecondsEvent.resize(frames);
             millisecondsUpdate.resize(frames);
@@ -175,6 +197,9 @@ namespace sre {
         if (ImGui::TreeNode(s.c_str())){
             ImGui::LabelText("Vertex count", "%i", mesh->getVertexCount());
             ImGui::LabelText("Mesh size", "%.2f MB", mesh->getDataSize()/(1000*1000.0f));
+            const char* usage[] = {"Static", "Dynamic", "Stream"};
+            ImGui::LabelText("Usage", "%s", usage[(int)mesh->getUsage()]);
+            ImGui::LabelText("Layout", "%s", mesh->getLayout() == MeshLayout::Separate ? "Separate" : "Interleaved");
             if (ImGui::TreeNode("Vertex attributes")){
                 auto attributeNames = mesh->getAttributeNames();
                 for (auto & a : attributeNames) {
@@ -198,8 +223,7 @@ namespace sre {
                 ImGui::TreePop();
             }
             if (ImGui::TreeNode("Mesh Data")) {
-                auto interleavedData = mesh->getInterleavedData();
-                auto attributes = mesh->attributeByName;
+                auto& attributes = mesh->attributeByName;
                 for (auto& att : attributes){
                     auto attributeName = att.first;
                     if (ImGui::TreeNode(attributeName.c_str())) {
@@ -228,24 +252,22 @@ namespace sre {
                             vertexOffset = std::min(vertexOffset+5,mesh->vertexCount-(mesh->vertexCount%5));
                         }
 
-                        if (dataType == GL_INT){
-                            for (int j=vertexOffset;j<std::min(vertexOffset+5,mesh->vertexCount); j++){
-                                std::string value;
-                                for (int i=0;i<att.second.elementCount;i++){
-                                    float* data = &interleavedData[att.second.offset/sizeof(float)+i + (j*mesh->totalBytesPerVertex)/sizeof(float)];
-                                    int* dataInt = reinterpret_cast<int*>(data);
-                                    value += std::to_string(*dataInt)+" ";
-                                }
-                                std::string label = "Value ";
-                                label+= std::to_string(j);
-                                ImGui::LabelText("%s %s", label.c_str(), value.c_str());
-                            }
+                        // values are read from the CPU data (before conversion to the GPU format)
+                        size_t size;
+                        int components;
+                        const float* values = mesh->getAttributeValues(attributeName, att.second, size, components);
+                        if (!mesh->hasCpuData()){
+                            ImGui::LabelText("Values", "CPU data not retained");
                         } else {
-                            for (int j=vertexOffset;j<std::min(vertexOffset+5,mesh->vertexCount); j++){
+                            for (int j=vertexOffset;j<std::min(vertexOffset+5,(int)size); j++){
                                 std::string value;
-                                for (int i=0;i<att.second.elementCount;i++){
-                                    float data = interleavedData[att.second.offset/sizeof(float)+i + (j*mesh->totalBytesPerVertex)/sizeof(float)];
-                                    value += std::to_string(data)+" ";
+                                for (int i=0;i<components;i++){
+                                    const float* data = values + j*components + i;
+                                    if (att.second.attributeType == GL_INT_VEC4){
+                                        value += std::to_string(*reinterpret_cast<const int*>(data))+" ";
+                                    } else {
+                                        value += std::to_string(*data)+" ";
+                                    }
                                 }
                                 std::string label = "Value ";
                                 label+= std::to_string(j);
@@ -283,7 +305,7 @@ namespace sre {
                 static auto litMat = Shader::getStandardBlinnPhong()->createMaterial();
                 static auto unlitMat = Shader::getUnlit()->createMaterial();
 
-                bool hasNormals = mesh->getNormals().size()>0;
+                bool hasNormals = mesh->hasAttribute("normal");
                 auto mat = hasNormals ? litMat : unlitMat;
                 auto sharedPtrMesh = mesh->shared_from_this();
                 float rotationSpeed = 0.001f;
@@ -586,7 +608,79 @@ namespace sre {
 
             ImGui::PlotLines(res,data.data(),frames, 0, "State changes", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
 
+            max = 0;
+            sum = 0;
+            for (int i=0;i<frames;i++){
+                int idx = (frameCount + i)%frames;
+                float t = stats[idx].objectsCulled;
+                data[(-frameCount%frames+idx+frames)%frames] = t;
+                max = std::max(max, t);
+                sum += t;
+            }
+            avg = 0;
+            if (frameCount > 0){
+                avg = sum / std::min(frameCount, frames);
+            }
+            const RenderStats& lastStats = stats[(frameCount+frames-1)%frames];
+            std::snprintf(res, sizeof(res), "Avg: %4.1f\n"
+                        "Max: %4.1f\n"
+                        "Cur: %4.1f\n"
+                        "Submitted: %i\n"
+                        "Drawn: %i"
+                              ,avg,max,data[frames-1],lastStats.objectsSubmitted,lastStats.objectsDrawn);
+
+            ImGui::PlotLines(res,data.data(),frames, 0, "Culled objects", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
+            max = 0;
+            sum = 0;
+            for (int i=0;i<frames;i++){
+                int idx = (frameCount + i)%frames;
+                float t = stats[idx].objectsOccluded;
+                data[(-frameCount%frames+idx+frames)%frames] = t;
+                max = std::max(max, t);
+                sum += t;
+            }
+            avg = 0;
+            if (frameCount > 0){
+                avg = sum / std::min(frameCount, frames);
+            }
+            std::snprintf(res, sizeof(res), "Avg: %4.1f\n"
+                        "Max: %4.1f\n"
+                        "Cur: %4.1f\n"
+                        "Visible: %i\n"
+                        "Queries: %i"
+                              ,avg,max,data[frames-1],lastStats.objectsVisible,lastStats.occlusionQueries);
+
+            ImGui::PlotLines(res,data.data(),frames, 0, "Occluded objects", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
+            max = 0;
+            sum = 0;
+            for (int i=0;i<frames;i++){
+                int idx = (frameCount + i)%frames;
+                float t = stats[idx].glCallsIssued;
+                data[(-frameCount%frames+idx+frames)%frames] = t;
+                max = std::max(max, t);
+                sum += t;
+            }
+            avg = 0;
+            if (frameCount > 0){
+                avg = sum / std::min(frameCount, frames);
+            }
+            std::snprintf(res, sizeof(res), "Avg: %4.1f\n"
+                        "Max: %4.1f\n"
+                        "Cur: %4.1f\n"
+                        "Skipped: %i"
+                              ,avg,max,data[frames-1],lastStats.glCallsSkipped);
+
+            ImGui::PlotLines(res,data.data(),frames, 0, "GL state calls", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
             plotTimings(millisecondsFrameTime.data(), "Frame-time ms");
+            if (lastStats.gpuFrame >= 0){
+                plotTimings(millisecondsGpu.data(), "GPU ms");
+                for (auto& timing : lastStats.renderPassTimings){
+                    ImGui::Text("%s: %4.2f ms", timing.name.empty() ? "RenderPass" : timing.name.c_str(), timing.gpuMilliseconds);
+                }
+            }
         }
         if (ImGui::CollapsingHeader("Frame inspector")){
             if (ImGui::Button("Capture frame")){
@@ -633,9 +727,9 @@ namespace sre {
                                 std::snprintf(label, sizeof(label), "Draw call #%i", i++);
                                 if (ImGui::TreeNode(label)) {
                                     ImGui::LabelText("Submesh", "%i", r.subMesh);
-                                    showMaterial(r.material.get());
+                                    showMaterial(r.material);
                                     showMatrix("ModelTransform", r.modelTransform);
-                                    showMesh(r.mesh.get());
+                                    showMesh(r.mesh);
                                     ImGui::TreePop();
                                 }
                             }
@@ -667,7 +761,9 @@ namespace sre {
             std::snprintf(res, sizeof(res), "Avg: %4.1f MB\n"
                         "Max: %4.1f MB\n"
                         "Cur: %4.1f MB\n"
-                        "Count: %i",avg,max,  data[frames-1],(int)r->meshes.size());
+                        "Count: %i\n"
+                        "Uploaded: %4.1f KB",avg,max,  data[frames-1],(int)r->meshes.size(),
+                        stats[(frameCount+frames-1)%frames].meshBytesUploaded/1000.0f);
 
             ImGui::PlotLines(res,data.data(),frames, 0, "Mesh MB", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
 
@@ -976,6 +1072,7 @@ namespace sre {
 
         stats[frameCount%frames] = Renderer::instance->getRenderStats();
         millisecondsFrameTime[frameCount%frames] = deltaTime;
+        millisecondsGpu[frameCount%frames] = stats[frameCount%frames].gpuMilliseconds;
         if (SDLRenderer::instance){
             millisecondsEvent[frameCount%frames] = SDLRenderer::instance->deltaTimeEvent;
             millisecondsUpdate[frameCount%frames] = SDLRenderer::instance->deltaTimeUpdate;
@@ -11,27 +11,102 @@
 #include <glm/gtc/color_space.hpp>
 #include "sre/Renderer.hpp"
 #include "sre/Log.hpp"
+#include <cstring>
 
 
 namespace sre {
+    uint16_t Material::materialIdCount = 0;
 
     Material::Material(std::shared_ptr<Shader> shader)
     :shader{nullptr}
     {
+        materialId = materialIdCount++;
         setShader(std::move(shader));
         name = "Undefined material";
     }
 
     Material::~Material(){
+        if (uniformBuffer != 0 && Renderer::instance){
+            glDeleteBuffers(1, &uniformBuffer);
+        }
     }
 
     void Material::bind(){
         if (shader->uniforms != uniforms){
             setShader(shader);
         }
+        if (shader->materialUniformBlockSize > 0){
+            updateUniformBuffer();
+            glBindBufferRange(GL_UNIFORM_BUFFER, Shader::materialUniformBindingIndex, uniformBuffer, 0, shader->materialUniformBlockSize);
+        }
         uniformMap.bind();
     }
 
+    void Material::updateUniformBuffer() {
+        if (uniformBuffer == 0){
+            glGenBuffers(1, &uniformBuffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+            glBufferData(GL_UNIFORM_BUFFER, uniformBufferData.size(), nullptr, GL_DYNAMIC_DRAW);
+            uniformBufferDirty = true;
+        } else if (!uniformBufferDirty && !uniformBufferHasArrays){
+            return;
+        } else {
+            glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+        }
+        // pack values using the std140 offsets and strides queried from the shader
+        char* data = uniformBufferData.data();
+        for (auto& u : *uniforms){
+            if (u.blockOffset < 0){
+                continue;
+            }
+            char* dst = data + u.blockOffset;
+            switch (u.type){
+                case UniformType::Vec4: {
+                    glm::vec4 value = uniformMap.get<glm::vec4>(u.id);
+                    memcpy(dst, glm::value_ptr(value), sizeof(glm::vec4));
+                }
+                    break;
+                case UniformType::Float: {
+                    float value = uniformMap.get<float>(u.id);
+                    memcpy(dst, &value, sizeof(float));
+                }
+                    break;
+                case UniformType::Mat4:
+                case UniformType::Mat4Array: {
+                    if (u.arraySize > 1) {
+                        auto values = uniformMap.get<std::shared_ptr<std::vector<glm::mat4>>>(u.id);
+                        if (values){
+                            for (size_t i = 0; i < values->size() && i < (size_t)u.arraySize; i++){
+                                memcpy(dst + i * u.arrayStride, glm::value_ptr((*values)[i]), sizeof(glm::mat4));
+                            }
+                        }
+                    } else {
+                        glm::mat4 value = uniformMap.get<glm::mat4>(u.id);
+                        memcpy(dst, glm::value_ptr(value), sizeof(glm::mat4));
+                    }
+                }
+                    break;
+                case UniformType::Mat3Array: {
+                    auto values = uniformMap.get<std::shared_ptr<std::vector<glm::mat3>>>(u.id);
+                    if (values){
+                        for (size_t i = 0; i < values->size() && i < (size_t)u.arraySize; i++){
+                            // std140 stores each column of a mat3 as a vec4
+                            for (int c = 0; c < 3; c++){
+                                memcpy(dst + i * u.arrayStride + c * u.matrixStride, glm::value_ptr((*values)[i][c]), sizeof(glm::vec3));
+                            }
+                        }
+                    }
+                }
+                    break;
+                default:
+                    break;
+            }
+        }
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, uniformBufferData.size(), data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        uniformBufferDirty = false;
+    }
+
     std::shared_ptr<sre::Shader> Material::getShader()  {
         return shader;
     }
@@ -52,11 +127,13 @@ namespace sre {
                 case UniformType::Texture:
                 {
                     uniformMap.set(u.id, Texture::getWhiteTexture());
+                    uniformMap.setTextureUnit(u.id, u.textureUnit);
                 }
                 break;
                 case UniformType::TextureCube:
                 {
                     uniformMap.set(u.id, Texture::getDefaultCubemapTexture());
+                    uniformMap.setTextureUnit(u.id, u.textureUnit);
                 }
                 break;
                 case UniformType::Float:
@@ -134,6 +211,20 @@ namespace sre {
             }
         }
         uniforms = shader->uniforms;
+
+        // the material uniform block (if any) is rewritten on next bind
+        if (uniformBuffer != 0 && (int)uniformBufferData.size() != shader->materialUniformBlockSize){
+            glDeleteBuffers(1, &uniformBuffer);
+            uniformBuffer = 0;
+        }
+        uniformBufferData.assign(shader->materialUniformBlockSize, 0);
+        uniformBufferDirty = true;
+        uniformBufferHasArrays = false;
+        for (auto& u : *uniforms){
+            if (u.blockOffset >= 0 && (u.arraySize > 1 || u.type == UniformType::Mat3Array)){
+                uniformBufferHasArrays = true;
+            }
+        }
     }
 
     Color Material::getColor()   {
@@ -171,12 +262,14 @@ namespace sre {
     bool Material::set(std::string uniformName, glm::vec4 value){
         auto type = shader->getUniform(uniformName);
         uniformMap.set(type.id, value);
+        uniformBufferDirty = true;
         return true;
     }
 
     bool Material::set(std::string uniformName, glm::mat4 value){
         auto type = shader->getUniform(uniformName);
         uniformMap.set(type.id, value);
+        uniformBufferDirty = true;
         return true;
     }
 
@@ -184,24 +277,28 @@ namespace sre {
     bool Material::set(std::string uniformName, std::shared_ptr<std::vector<glm::mat3>> value){
         auto type = shader->getUniform(uniformName);
         uniformMap.set(type.id, value);
+        uniformBufferDirty = true;
         return true;
     }
 
     bool Material::set(std::string uniformName, std::shared_ptr<std::vector<glm::mat4>> value){
         auto type = shader->getUniform(uniformName);
         uniformMap.set(type.id, value);
+        uniformBufferDirty = true;
         return true;
     }
 
     bool Material::set(std::string uniformName, Color value){
         auto type = shader->getUniform(uniformName);
         uniformMap.set(type.id, value);
+        uniformBufferDirty = true;
         return true;
     }
 
     bool Material::set(std::string uniformName, float value){
         auto type = shader->getUniform(uniformName);
         uniformMap.set(type.id, value);
+        uniformBufferDirty = true;
         return true;
     }
 
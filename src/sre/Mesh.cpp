@@ -22,21 +22,56 @@
 #include "sre/RenderPass.hpp"
 #include "sre/Shader.hpp"
 #include "sre/Log.hpp"
+#include "sre/impl/GeometryPool.hpp"
+#include "sre/impl/VertexPacking.hpp"
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 class Material;
 
 namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        GLenum toGLUsage(MeshUsage usage){
+            switch (usage){
+                case MeshUsage::Dynamic:
+                    return GL_DYNAMIC_DRAW;
+                case MeshUsage::Stream:
+                    return GL_STREAM_DRAW;
+                default:
+                    return GL_STATIC_DRAW;
+            }
+        }
+
+        template<typename T>
+        const std::vector<T>& findAttribute(const std::map<std::string,std::vector<T>>& attributes, const std::string& name){
+            static const std::vector<T> empty;
+            auto res = attributes.find(name);
+            return res != attributes.end() ? res->second : empty;
+        }
+
+        int attributeComponents(int attributeType){
+            switch (attributeType){
+                case GL_FLOAT:
+                    return 1;
+                case GL_FLOAT_VEC2:
+                    return 2;
+                case GL_FLOAT_VEC3:
+                    return 3;
+                default:
+                    return 4;
+            }
+        }
+    }
+
     uint16_t Mesh::meshIdCount = 0;
 
-    Mesh::Mesh(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material)
+    Mesh::Mesh(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material, bool useGeometryPool, std::map<std::string,VertexAttributeFormat> attributeFormats, MeshUsage usage, MeshLayout layout, bool retainCpuData)
     {
         meshId = meshIdCount++;
         if ( Renderer::instance == nullptr){
             LOG_FATAL("Cannot instantiate sre::Mesh before sre::Renderer is created.");
         }
-        glGenBuffers(1, &vertexBufferId);
         update(std::move(attributesFloat),
                std::move(attributesVec2),
                std::move(attributesVec3),
@@ -50,7 +85,12 @@ namespace sre {
                location,
                rotation,
                scaling,
-               material);
+               material,
+               useGeometryPool,
+               std::move(attributeFormats),
+               usage,
+               layout,
+               retainCpuData);
         Renderer::instance->meshes.emplace_back(this);
     }
 
@@ -70,29 +110,55 @@ namespace sre {
                     glDeleteVertexArrays(1, &(arrayObj.second.vaoID));
                 }
             }
-            glDeleteBuffers(1, &vertexBufferId);
+            if (geometryPool != nullptr){
+                geometryPool->remove(this);
+            }
+            if (vertexBufferId != 0){
+                glDeleteBuffers(1, &vertexBufferId);
+            }
             if (elementBufferId != 0){
                 glDeleteBuffers(1, &elementBufferId);
             }
+            streamVertexBuffers.release(vertexBufferId);
+            streamElementBuffers.release(elementBufferId);
+            releaseAttributeBuffers(true);
+        }
+    }
+
+    void Mesh::StreamBuffers::next(unsigned int& current) {
+        buffers[index] = current;
+        index = (index + 1) % streamBufferCount;
+        current = buffers[index];
+    }
+
+    void Mesh::StreamBuffers::release(unsigned int current) {
+        for (auto& buffer : buffers){
+            if (buffer != 0 && buffer != current){
+                glDeleteBuffers(1, &buffer);
+            }
+            buffer = 0;
         }
+        index = 0;
     }
 
     void Mesh::bind(Shader* shader) {
         if (renderInfo().graphicsAPIVersionMajor >= 3) {
-            auto res = shaderToVertexArrayObject.find(shader->shaderProgramId);
-            if (res != shaderToVertexArrayObject.end() && res->second.shaderId == shader->shaderUniqueId) {
+            // meshes in a geometry pool share the vertex array objects of the pool
+            auto& vertexArrayObjects = geometryPool ? geometryPool->shaderToVertexArrayObject : shaderToVertexArrayObject;
+            auto res = vertexArrayObjects.find(shader->shaderProgramId);
+            if (res != vertexArrayObjects.end() && res->second.shaderId == shader->shaderUniqueId && res->second.vertexBufferVersion == vertexBufferVersion) {
                 GLuint vao = res->second.vaoID;
                 glBindVertexArray(vao);
             } else {
                 GLuint index;
-                if (res != shaderToVertexArrayObject.end()){
+                if (res != vertexArrayObjects.end()){
                     index = res->second.vaoID;
                 } else {
                     glGenVertexArrays(1, &index);
                 }
                 glBindVertexArray(index);
                 setVertexAttributePointers(shader);
-                shaderToVertexArrayObject[shader->shaderProgramId] = {shader->shaderUniqueId, index};
+                vertexArrayObjects[shader->shaderProgramId] = {shader->shaderUniqueId, index, vertexBufferVersion};
                 bindIndexSet();
             }
         } else {
@@ -116,9 +182,10 @@ namespace sre {
         return vertexCount;
     }
 
-    void Mesh::update(std::map<std::string,std::vector<float>>&& attributesFloat,std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string,std::vector<glm::vec3>>&& attributesVec3,std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material) {
+    void Mesh::update(std::map<std::string,std::vector<float>>&& attributesFloat,std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string,std::vector<glm::vec3>>&& attributesVec3,std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material, bool useGeometryPool, std::map<std::string,VertexAttributeFormat> attributeFormats, MeshUsage usage, MeshLayout layout, bool retainCpuData) {
         this->meshTopology = meshTopology;
         this->name = name;
+        this->lineWidth = lineWidth;
         meshId = meshIdCount++;
 
         vertexCount = 0;
@@ -138,17 +205,104 @@ namespace sre {
         this->attributesVec3  = std::move(attributesVec3);
         this->attributesVec4  = std::move(attributesVec4);
         this->attributesIVec4 = std::move(attributesIVec4);
+        this->attributeFormats = std::move(attributeFormats);
+        if (usage != MeshUsage::Stream){
+            streamVertexBuffers.release(vertexBufferId);
+            streamElementBuffers.release(elementBufferId);
+            for (auto& buffer : attributeBuffers){
+                buffer.second.streamBuffers.release(buffer.second.bufferId);
+            }
+        }
+        this->usage = usage;
+        this->layout = layout;
 
-        auto interleavedData = getInterleavedData();
+        // the separate layout uploads each attribute (see uploadAttributeBuffer())
+        auto interleavedData = getInterleavedData(layout == MeshLayout::Interleaved);
+        releaseAttributeBuffers(layout == MeshLayout::Interleaved);
 
         if (renderInfo().graphicsAPIVersionMajor >= 3) {
             glBindVertexArray(0);
         }
-        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float)*interleavedData.size(), interleavedData.data(), GL_STATIC_DRAW);
+        if (geometryPool != nullptr){
+            geometryPool->remove(this); // the ranges are allocated again (the size may differ)
+        }
+        if (useGeometryPool && usage == MeshUsage::Stream){
+            LOG_WARNING("Mesh %s: stream meshes are not stored in a geometry pool", this->name.c_str());
+            useGeometryPool = false;
+        }
+        if (useGeometryPool && layout == MeshLayout::Separate){
+            LOG_WARNING("Mesh %s: meshes with separate attribute buffers are not stored in a geometry pool", this->name.c_str());
+            useGeometryPool = false;
+        }
+        if (useGeometryPool && Renderer::instance->geometryPoolSupported){
+            // the buffers of the pool are used instead
+            if (vertexBufferId != 0){
+                glDeleteBuffers(1, &vertexBufferId);
+                vertexBufferId = 0;
+            }
+            if (elementBufferId != 0){
+                glDeleteBuffers(1, &elementBufferId);
+                elementBufferId = 0;
+            }
+            Renderer::instance->getGeometryPool(getLayoutKey(), totalBytesPerVertex)->add(this, interleavedData);
+        } else {
+            if (usage == MeshUsage::Stream){
+                // the previous buffers may still be read by the GPU
+                streamVertexBuffers.next(vertexBufferId);
+                streamElementBuffers.next(elementBufferId);
+            }
+            if (layout == MeshLayout::Separate){
+                streamVertexBuffers.release(vertexBufferId);
+                if (vertexBufferId != 0){
+                    glDeleteBuffers(1, &vertexBufferId);
+                    vertexBufferId = 0;
+                }
+                for (auto& attribute : attributeByName){
+                    uploadAttributeBuffer(attribute.first, 0, vertexCount, true);
+                }
+            } else {
+                if (vertexBufferId == 0){
+                    glGenBuffers(1, &vertexBufferId);
+                }
+                glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+                glBufferData(GL_ARRAY_BUFFER, sizeof(float)*interleavedData.size(), interleavedData.data(), toGLUsage(usage));
+            }
+
+            updateIndexBuffers();
+        }
+
+        computeBounds();
+        int bytesPerVertex = totalBytesPerVertex;
+        if (layout == MeshLayout::Separate){
+            bytesPerVertex = 0;
+            for (auto& buffer : attributeBuffers){
+                bytesPerVertex += buffer.second.stride;
+            }
+        }
+        dataSize = bytesPerVertex * vertexCount;
 
-        updateIndexBuffers();
+        renderStats.meshBytes += dataSize;
+        renderStats.meshBytesAllocated += dataSize;
+        renderStats.meshBytesUploaded += dataSize;
 
+        this->location = location;
+        this->rotation = rotation;
+        this->scaling = scaling;
+        this->material = material;
+
+        this->retainCpuData = retainCpuData;
+        if (!retainCpuData){
+            // the bounds and the attribute layout are kept
+            this->attributesFloat.clear();
+            this->attributesVec2.clear();
+            this->attributesVec3.clear();
+            this->attributesVec4.clear();
+            this->attributesIVec4.clear();
+            this->indices.clear();
+        }
+    }
+
+    void Mesh::computeBounds() {
         boundsMinMax[0] = glm::vec3{std::numeric_limits<float>::max()};
         boundsMinMax[1] = glm::vec3{-std::numeric_limits<float>::max()};
         auto pos = this->attributesVec3.find("position");
@@ -158,16 +312,167 @@ namespace sre {
                 boundsMinMax[1] = glm::max(boundsMinMax[1], v);
             }
         }
-        dataSize = totalBytesPerVertex * vertexCount;
+    }
 
-        renderStats.meshBytes += dataSize;
-        renderStats.meshBytesAllocated += dataSize;
+    template<typename T>
+    void Mesh::updateAttributeValues(std::map<std::string,std::vector<T>>& attributes, const std::string& name, const std::vector<T>& values, int firstVertex) {
+        if (!retainCpuData){
+            LOG_ERROR("Mesh %s: updateAttribute() requires the CPU data (see MeshBuilder::withRetainCpuData())", this->name.c_str());
+            return;
+        }
+        auto res = attributes.find(name);
+        if (res == attributes.end()){
+            LOG_ERROR("Mesh %s has no vertex attribute %s of the given type", this->name.c_str(), name.c_str());
+            return;
+        }
+        int count = (int)values.size();
+        if (firstVertex < 0 || firstVertex + count > vertexCount){
+            LOG_ERROR("Vertices %i to %i out of bounds (vertex count is %i). Use update() to change the vertex count.", firstVertex, firstVertex + count, vertexCount);
+            return;
+        }
+        if (count == 0){
+            return;
+        }
+        auto& dest = res->second;
+        if ((int)dest.size() < firstVertex + count){
+            dest.resize(firstVertex + count);
+        }
+        std::copy(values.begin(), values.end(), dest.begin() + firstVertex);
+        if (layout == MeshLayout::Separate){
+            uploadAttributeBuffer(name, firstVertex, count, false);
+        } else if (usage == MeshUsage::Stream && geometryPool == nullptr){
+            // all vertices are written to the next buffer (the GPU may still read the current)
+            streamVertexBuffers.next(vertexBufferId);
+            vertexBufferVersion++;
+            uploadVertices(0, vertexCount);
+        } else {
+            uploadVertices(firstVertex, count);
+        }
+        if (name == "position"){
+            computeBounds();
+        }
+    }
 
-        this->lineWidth = lineWidth;
-        this->location = location;
-        this->rotation = rotation;
-        this->scaling = scaling;
-        this->material = material;
+    void Mesh::updateAttribute(const std::string& name, const std::vector<float>& values, int firstVertex) {
+        updateAttributeValues(attributesFloat, name, values, firstVertex);
+    }
+
+    void Mesh::updateAttribute(const std::string& name, const std::vector<glm::vec2>& values, int firstVertex) {
+        updateAttributeValues(attributesVec2, name, values, firstVertex);
+    }
+
+    void Mesh::updateAttribute(const std::string& name, const std::vector<glm::vec3>& values, int firstVertex) {
+        updateAttributeValues(attributesVec3, name, values, firstVertex);
+    }
+
+    void Mesh::updateAttribute(const std::string& name, const std::vector<glm::vec4>& values, int firstVertex) {
+        updateAttributeValues(attributesVec4, name, values, firstVertex);
+    }
+
+    void Mesh::updateAttribute(const std::string& name, const std::vector<glm::i32vec4>& values, int firstVertex) {
+        updateAttributeValues(attributesIVec4, name, values, firstVertex);
+    }
+
+    void Mesh::uploadVertices(int firstVertex, int count) {
+        // the vertices are stored without gaps, so the range is uploaded as a whole (including the other attributes)
+        std::vector<char> data((size_t)count * totalBytesPerVertex, 0);
+        for (auto & attribute : attributeByName){
+            packAttribute(attribute.first, attribute.second, firstVertex, count, data.data() + attribute.second.offset, totalBytesPerVertex);
+        }
+        // the array buffer binding is not part of the vertex array object state
+        if (usage == MeshUsage::Stream && geometryPool == nullptr){
+            // the next stream buffer may be unused or have the size of an older vertex count
+            if (vertexBufferId == 0){
+                glGenBuffers(1, &vertexBufferId);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+            glBufferData(GL_ARRAY_BUFFER, data.size(), data.data(), toGLUsage(usage));
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+            glBufferSubData(GL_ARRAY_BUFFER, (size_t)(baseVertex + firstVertex) * totalBytesPerVertex, data.size(), data.data());
+        }
+        Renderer::instance->renderStats.meshBytesUploaded += (int)data.size();
+    }
+
+    void Mesh::uploadAttributeBuffer(const std::string& name, int firstVertex, int count, bool reallocate) {
+        auto& attribute = attributeByName.at(name);
+        auto& buffer = attributeBuffers[name];
+        buffer.stride = vertexAttributeBytes(attribute.format, attributeComponents(attribute.attributeType));
+        if (usage == MeshUsage::Stream){
+            // all vertices of the attribute are written to the next buffer (the GPU may still read the current)
+            buffer.streamBuffers.next(buffer.bufferId);
+            vertexBufferVersion++;
+            firstVertex = 0;
+            count = vertexCount;
+            reallocate = true;
+        }
+        std::vector<char> data((size_t)count * buffer.stride, 0);
+        packAttribute(name, attribute, firstVertex, count, data.data(), buffer.stride);
+        if (buffer.bufferId == 0){
+            glGenBuffers(1, &buffer.bufferId);
+            reallocate = true;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.bufferId);
+        if (reallocate){
+            glBufferData(GL_ARRAY_BUFFER, data.size(), data.data(), toGLUsage(usage));
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, (size_t)firstVertex * buffer.stride, data.size(), data.data());
+        }
+        Renderer::instance->renderStats.meshBytesUploaded += (int)data.size();
+    }
+
+    void Mesh::packAttribute(const std::string& name, const Attribute& attribute, int firstVertex, int count, char* dest, int stride) {
+        size_t size;
+        int components;
+        const float* values = getAttributeValues(name, attribute, size, components);
+        for (size_t i = firstVertex; i < std::min(size, (size_t)(firstVertex + count)); i++){
+            packVertexAttribute(attribute.format, values + i * components, components, dest + stride * (i - firstVertex));
+        }
+    }
+
+    const float* Mesh::getAttributeValues(const std::string& name, const Attribute& attribute, size_t& size, int& components) {
+        components = attributeComponents(attribute.attributeType);
+        switch (attribute.attributeType){
+            case GL_FLOAT: {
+                auto& v = findAttribute(attributesFloat, name);
+                size = v.size();
+                return v.data();
+            }
+            case GL_FLOAT_VEC2: {
+                auto& v = findAttribute(attributesVec2, name);
+                size = v.size();
+                return reinterpret_cast<const float*>(v.data());
+            }
+            case GL_FLOAT_VEC3: {
+                auto& v = findAttribute(attributesVec3, name);
+                size = v.size();
+                return reinterpret_cast<const float*>(v.data());
+            }
+            case GL_FLOAT_VEC4: {
+                auto& v = findAttribute(attributesVec4, name);
+                size = v.size();
+                return reinterpret_cast<const float*>(v.data());
+            }
+            default: {
+                auto& v = findAttribute(attributesIVec4, name);
+                size = v.size();
+                return reinterpret_cast<const float*>(v.data());
+            }
+        }
+    }
+
+    void Mesh::releaseAttributeBuffers(bool all) {
+        for (auto it = attributeBuffers.begin(); it != attributeBuffers.end();){
+            if (all || attributeByName.find(it->first) == attributeByName.end()){
+                it->second.streamBuffers.release(it->second.bufferId);
+                if (it->second.bufferId != 0){
+                    glDeleteBuffers(1, &it->second.bufferId);
+                }
+                it = attributeBuffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 
     void Mesh::updateIndexBuffers() {
@@ -223,7 +528,7 @@ namespace sre {
                 }
             }
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferId);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, offset, concatenatedIndices.data(), GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, offset, concatenatedIndices.data(), toGLUsage(usage));
 
             this->dataSize += offset;
         }
@@ -246,10 +551,18 @@ namespace sre {
                                                      );
             if (attributeFoundInMesh &&  equalType && shaderAttribute.second.arraySize == 1) {
                 glEnableVertexAttribArray(shaderAttribute.second.position);
+                int stride = totalBytesPerVertex;
+                int offset = meshAttribute->second.offset;
+                if (layout == MeshLayout::Separate){
+                    auto& buffer = attributeBuffers[shaderAttribute.first];
+                    glBindBuffer(GL_ARRAY_BUFFER, buffer.bufferId);
+                    stride = buffer.stride;
+                    offset = 0;
+                }
                 if ((shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)){
-                    glVertexAttribIPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
+                    glVertexAttribIPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, stride, BUFFER_OFFSET(offset));
                 } else {
-                    glVertexAttribPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, GL_FALSE, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
+                    glVertexAttribPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, meshAttribute->second.normalized ? GL_TRUE : GL_FALSE, stride, BUFFER_OFFSET(offset));
                 }
                 vertexAttribArray++;
             } else {
@@ -281,35 +594,31 @@ namespace sre {
         }
     }
 
-    std::vector<glm::vec3> Mesh::getPositions() {
-        std::vector<glm::vec3> res;
-        auto ref = attributesVec3.find("position");
-        if (ref != attributesVec3.end()){
-            res = ref->second;
-        }
-        return res;
+    const std::vector<glm::vec3>& Mesh::getPositions() {
+        return findAttribute(attributesVec3, "position");
     }
 
-    std::vector<glm::vec3> Mesh::getNormals() {
-        std::vector<glm::vec3> res;
-        auto ref = attributesVec3.find("normal");
-        if (ref != attributesVec3.end()){
-            res = ref->second;
-        }
-        return res;
+    const std::vector<glm::vec3>& Mesh::getNormals() {
+        return findAttribute(attributesVec3, "normal");
     }
 
-    std::vector<glm::vec4> Mesh::getUVs() {
-        std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("uv");
-        if (ref != attributesVec4.end()){
-            res = ref->second;
-        }
-        return res;
+    const std::vector<glm::vec4>& Mesh::getUVs() {
+        return findAttribute(attributesVec4, "uv");
     }
 
     const std::vector<uint32_t>& Mesh::getIndices(int indexSet) {
-        return indices.at(indexSet);
+        if (indexSet < 0 || indexSet >= (int)indices.size()){
+            static const std::vector<uint32_t> empty;
+            if (retainCpuData){
+                LOG_ERROR("Indexset %i out of bounds.",indexSet);
+            }
+            return empty;
+        }
+        return indices[indexSet];
+    }
+
+    bool Mesh::hasCpuData() {
+        return retainCpuData;
     }
 
     Mesh::MeshBuilder Mesh::update() {
@@ -324,6 +633,11 @@ namespace sre {
 
         res.indices = indices;
         res.meshTopology = meshTopology;
+        res.useGeometryPool = geometryPool != nullptr;
+        res.attributeFormats = attributeFormats;
+        res.usage = usage;
+        res.layout = layout;
+        res.retainCpuData = retainCpuData;
         return res;
     }
 
@@ -331,22 +645,12 @@ namespace sre {
         return Mesh::MeshBuilder();
     }
 
-    std::vector<glm::vec4> Mesh::getColors() {
-        std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("color");
-        if (ref != attributesVec4.end()){
-            res = ref->second;
-        }
-        return res;
+    const std::vector<glm::vec4>& Mesh::getColors() {
+        return findAttribute(attributesVec4, "color");
     }
 
-    std::vector<float> Mesh::getParticleSizes() {
-        std::vector<float> res;
-        auto ref = attributesFloat.find("particleSize");
-        if (ref != attributesFloat.end()){
-            res = ref->second;
-        }
-        return res;
+    const std::vector<float>& Mesh::getParticleSizes() {
+        return findAttribute(attributesFloat, "particleSize");
     }
 
     int Mesh::getDataSize() {
@@ -389,6 +693,28 @@ namespace sre {
                           material);
     }
 
+    bool Mesh::isInGeometryPool() {
+        return geometryPool != nullptr;
+    }
+
+    MeshUsage Mesh::getUsage() {
+        return usage;
+    }
+
+    MeshLayout Mesh::getLayout() {
+        return layout;
+    }
+
+    std::string Mesh::getLayoutKey() {
+        std::stringstream ss;
+        for (auto& attribute : attributeByName){
+            ss << attribute.first << ':' << attribute.second.offset << ':' << attribute.second.attributeType << ':'
+               << attribute.second.dataType << ':' << attribute.second.normalized << ';';
+        }
+        ss << totalBytesPerVertex << ';' << lineWidth;
+        return ss.str();
+    }
+
     std::array<glm::vec3,2> Mesh::getBoundsMinMax() {
         return boundsMinMax;
     }
@@ -401,6 +727,14 @@ namespace sre {
         return {-1,-1};
     }
 
+    VertexAttributeFormat Mesh::getAttributeFormat(const std::string &name) {
+        auto res = attributeFormats.find(name);
+        if (res != attributeFormats.end()){
+            return res->second;
+        }
+        return VertexAttributeFormat::Float;
+    }
+
     std::vector<std::string> Mesh::getAttributeNames() {
         std::vector<std::string> res;
         for (auto & u : attributeByName){
@@ -410,7 +744,7 @@ namespace sre {
     }
 
     int Mesh::getIndexSets() {
-        return indices.size();
+        return (int)elementBufferOffsetCount.size();
     }
 
     const std::string& Mesh::getName() {
@@ -418,23 +752,21 @@ namespace sre {
     }
 
     int Mesh::getIndicesSize(int indexSet) {
-        if (indexSet < indices.size()) {
-            return static_cast<int>(indices[indexSet].size());
+        if (indexSet < elementBufferOffsetCount.size()) {
+            return static_cast<int>(elementBufferOffsetCount[indexSet].size);
         }
         LOG_ERROR("Indexset %i out of bounds.",indexSet);
         return -1;
     }
 
-    std::vector<glm::vec4> Mesh::getTangents() {
-        std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("tangent");
-        if (ref != attributesVec4.end()){
-            res = ref->second;
-        }
-        return res;
+    const std::vector<glm::vec4>& Mesh::getTangents() {
+        return findAttribute(attributesVec4, "tangent");
     }
 
-    std::vector<float> Mesh::getInterleavedData() {
+    std::vector<float> Mesh::getInterleavedData(bool fill) {
+        if (!attributeFormats.empty() && renderInfo().graphicsAPIVersionMajor >= 3){
+            return getCompactInterleavedData(fill);
+        }
         totalBytesPerVertex = 0;
         std::vector<int> offset;
         // enforced std140 layout rules ( https://learnopengl.com/#!Advanced-OpenGL/Advanced-GLSL )
@@ -473,6 +805,9 @@ namespace sre {
         if (totalBytesPerVertex%(sizeof(float)*4) != 0) {
             totalBytesPerVertex += sizeof(float)*4 - totalBytesPerVertex%(sizeof(float)*4);
         }
+        if (!fill){
+            return {};
+        }
         std::vector<float> interleavedData((vertexCount * totalBytesPerVertex) / sizeof(float), 0);
         const char * dataPtr = (char*) interleavedData.data();
 
@@ -515,6 +850,91 @@ namespace sre {
         return interleavedData;
     }
 
+    std::vector<float> Mesh::getCompactInterleavedData(bool fill) {
+        struct Source {
+            const std::string* name;
+            const void* values;
+            int components;
+            size_t count;
+            int attributeType;
+            VertexAttributeFormat format;
+        };
+        // same order as getInterleavedData(): vec3, vec4, ivec4, vec2, float
+        std::vector<Source> sources;
+        for (auto & pair : attributesVec3){
+            sources.push_back({&pair.first, pair.second.data(), 3, pair.second.size(), GL_FLOAT_VEC3, getAttributeFormat(pair.first)});
+        }
+        for (auto & pair : attributesVec4){
+            sources.push_back({&pair.first, pair.second.data(), 4, pair.second.size(), GL_FLOAT_VEC4, getAttributeFormat(pair.first)});
+        }
+        for (auto & pair : attributesIVec4){
+            sources.push_back({&pair.first, pair.second.data(), 4, pair.second.size(), GL_INT_VEC4, VertexAttributeFormat::Float});
+        }
+        for (auto & pair : attributesVec2){
+            sources.push_back({&pair.first, pair.second.data(), 2, pair.second.size(), GL_FLOAT_VEC2, getAttributeFormat(pair.first)});
+        }
+        for (auto & pair : attributesFloat){
+            sources.push_back({&pair.first, pair.second.data(), 1, pair.second.size(), GL_FLOAT, getAttributeFormat(pair.first)});
+        }
+
+        // each attribute is aligned to 4 bytes (no vec4 padding)
+        totalBytesPerVertex = 0;
+        for (auto & source : sources){
+            vertexCount = std::max(vertexCount, (int)source.count);
+            bool packed = source.format == VertexAttributeFormat::UNorm10_10_10_2 || source.format == VertexAttributeFormat::SNorm10_10_10_2;
+            if (packed && source.components < 3){
+                LOG_WARNING("Vertex attribute %s: packed 10_10_10_2 format requires vec3 or vec4. Using float.", source.name->c_str());
+                source.format = VertexAttributeFormat::Float;
+                packed = false;
+            }
+            int dataType;
+            switch (source.format){
+                case VertexAttributeFormat::Half:
+                    dataType = GL_HALF_FLOAT;
+                    break;
+                case VertexAttributeFormat::UNorm8:
+                    dataType = GL_UNSIGNED_BYTE;
+                    break;
+                case VertexAttributeFormat::SNorm8:
+                    dataType = GL_BYTE;
+                    break;
+                case VertexAttributeFormat::UNorm16:
+                    dataType = GL_UNSIGNED_SHORT;
+                    break;
+                case VertexAttributeFormat::SNorm16:
+                    dataType = GL_SHORT;
+                    break;
+                case VertexAttributeFormat::UNorm10_10_10_2:
+                    dataType = GL_UNSIGNED_INT_2_10_10_10_REV;
+                    break;
+                case VertexAttributeFormat::SNorm10_10_10_2:
+                    dataType = GL_INT_2_10_10_10_REV;
+                    break;
+                default:
+                    dataType = source.attributeType == GL_INT_VEC4 ? GL_INT : GL_FLOAT;
+                    break;
+            }
+            bool normalized = source.format != VertexAttributeFormat::Float && source.format != VertexAttributeFormat::Half;
+            attributeByName[*source.name] = {totalBytesPerVertex, packed ? 4 : source.components, dataType, source.attributeType, normalized, source.format};
+            totalBytesPerVertex += vertexAttributeBytes(source.format, source.components);
+        }
+        if (!fill){
+            return {};
+        }
+        std::vector<float> interleavedData((vertexCount * totalBytesPerVertex) / sizeof(float), 0);
+        char * dataPtr = (char*) interleavedData.data();
+
+        // add data (convert each element into interleaved buffer)
+        for (auto & source : sources){
+            int offset = attributeByName[*source.name].offset;
+            auto values = static_cast<const float*>(source.values);    // i32vec4 values are copied as is (using the float format)
+            for (size_t i=0;i<source.count;i++){
+                packVertexAttribute(source.format, values + i * source.components, source.components, dataPtr + totalBytesPerVertex * i + offset);
+            }
+        }
+        return interleavedData;
+    }
+
     void Mesh::setBoundsMinMax(const std::array<glm::vec3,2>& minMax) {
         boundsMinMax = minMax;
     }
@@ -775,14 +1195,20 @@ namespace sre {
             }
         }
         if (updateMesh != nullptr){
+            if (!updateMesh->retainCpuData && attributesFloat.empty() && attributesVec2.empty() && attributesVec3.empty() &&
+                    attributesVec4.empty() && attributesIVec4.empty()){
+                // the CPU data was freed after upload, so Mesh::update() has no vertex data to rebuild the mesh from
+                LOG_ERROR("Mesh %s: update() without vertex attributes requires the CPU data (see MeshBuilder::withRetainCpuData()). The mesh is not changed.", updateMesh->name.c_str());
+                return updateMesh->shared_from_this();
+            }
             renderStats.meshBytes -= updateMesh->getDataSize();
-            updateMesh->update(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices), meshTopology, name, renderStats, lineWidth, location, rotation, scaling, material);
+            updateMesh->update(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices), meshTopology, name, renderStats, lineWidth, location, rotation, scaling, material, useGeometryPool, std::move(attributeFormats), usage, layout, retainCpuData);
 
 
             return updateMesh->shared_from_this();
         }
 
-        auto res = new Mesh(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices),meshTopology, name, renderStats, lineWidth, location, rotation, scaling, material);
+        auto res = new Mesh(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices),meshTopology, name, renderStats, lineWidth, location, rotation, scaling, material, useGeometryPool, std::move(attributeFormats), usage, layout, retainCpuData);
         renderStats.meshCount++;
 
         return std::shared_ptr<Mesh>(res);
@@ -1266,6 +1692,15 @@ namespace sre {
         return *this;
     }
 
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withAttributeFormat(std::string name, VertexAttributeFormat format) {
+        if (format == VertexAttributeFormat::Float){
+            attributeFormats.erase(name);
+        } else {
+            attributeFormats[name] = format;
+        }
+        return *this;
+    }
+
     Mesh::MeshBuilder &Mesh::MeshBuilder::withName(const std::string& name) {
         this->name = name;
         return *this;
@@ -1276,6 +1711,26 @@ namespace sre {
         return *this;
     }
 
+    Mesh::MeshBuilder& Mesh::MeshBuilder::withGeometryPool(bool enabled){
+        useGeometryPool = enabled;
+        return *this;
+    }
+
+    Mesh::MeshBuilder& Mesh::MeshBuilder::withUsage(MeshUsage usage){
+        this->usage = usage;
+        return *this;
+    }
+
+    Mesh::MeshBuilder& Mesh::MeshBuilder::withLayout(MeshLayout layout){
+        this->layout = layout;
+        return *this;
+    }
+
+    Mesh::MeshBuilder& Mesh::MeshBuilder::withRetainCpuData(bool enabled){
+        retainCpuData = enabled;
+        return *this;
+    }
+
     Mesh::MeshBuilder& Mesh::MeshBuilder::withRecomputeTangents(bool enabled){
         recomputeTangents = enabled;
         return *this;
@@ -1350,12 +1805,22 @@ namespace sre {
         // Size used is same for all vectors -- use m_colors to set index
         for (int i = 0; i < m_colors.size(); i++) {
             if (m_status[i] == MeshStatus::Uninitialized) {
-                m_meshes[i] = sre::Mesh::create()
+                if (m_meshes[i] != nullptr) {
+                    // (update() does not keep the material and line width)
+                    m_meshes[i]->update()
                                     .withMaterial(m_materials[i])
                                     .withLineWidth(m_lineWidths[i])
-                                    .withMeshTopology(m_topologies[i])
                                     .withPositions(m_vertices[i])
                                     .build();
+                } else {
+                    m_meshes[i] = sre::Mesh::create()
+                                        .withMaterial(m_materials[i])
+                                        .withLineWidth(m_lineWidths[i])
+                                        .withMeshTopology(m_topologies[i])
+                                        .withPositions(m_vertices[i])
+                                        .withUsage(MeshUsage::Stream)
+                                        .build();
+                }
                 m_status[i] = MeshStatus::Initialized;
             }
             m_meshes[i]->draw(renderPass);
@@ -0,0 +1,120 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/PixelReadback.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Log.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace sre {
+    PixelReadback::PixelReadback(glm::ivec2 size, bool raw)
+    :size(size), raw(raw)
+    {
+        byteSize = (size_t)size.x * size.y * (raw ? sizeof(glm::u8vec4) : sizeof(Color));
+    }
+
+    PixelReadback::~PixelReadback() {
+        release();
+    }
+
+    void PixelReadback::read(int x, int y) {
+#ifdef EMSCRIPTEN
+        // WebGL cannot map buffers: read synchronously
+        data.resize(byteSize);
+        glReadPixels(x, y, size.x, size.y, GL_RGBA, raw ? GL_UNSIGNED_BYTE : GL_FLOAT, data.data());
+        resolved = true;
+#else
+        buffer = Renderer::instance->acquirePixelPackBuffer(byteSize);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glReadPixels(x, y, size.x, size.y, GL_RGBA, raw ? GL_UNSIGNED_BYTE : GL_FLOAT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+    }
+
+    bool PixelReadback::isReady() {
+        if (resolved){
+            return true;
+        }
+#ifndef EMSCRIPTEN
+        // flush to make sure the fence is eventually signalled
+        GLenum res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        return res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED;
+#else
+        return true;
+#endif
+    }
+
+    void PixelReadback::resolve() {
+        if (resolved){
+            return;
+        }
+#ifndef EMSCRIPTEN
+        if (!isReady()){
+            LOG_WARNING("PixelReadback read before the GPU finished (this stalls the pipeline)");
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        data.resize(byteSize);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, byteSize, GL_MAP_READ_BIT);
+        if (mapped != nullptr){
+            memcpy(data.data(), mapped, byteSize);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            LOG_ERROR("Cannot map pixel pack buffer");
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+        resolved = true;
+        release();
+    }
+
+    void PixelReadback::release() {
+#ifndef EMSCRIPTEN
+        if (Renderer::instance == nullptr){
+            return;
+        }
+        if (fence != nullptr){
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (buffer != 0){
+            Renderer::instance->releasePixelPackBuffer(buffer, byteSize);
+            buffer = 0;
+        }
+#endif
+    }
+
+    std::vector<Color> PixelReadback::getPixels() {
+        LOG_ASSERT(!raw && "getPixels() expects a readback of RenderPass::readPixelsAsync()");
+        resolve();
+        // the pixels are GL_RGBA / GL_FLOAT (Color is not trivially copyable, so each is constructed)
+        size_t count = std::min(data.size() / (4 * sizeof(float)), (size_t)(size.x * size.y));
+        std::vector<Color> res;
+        res.reserve(size.x * size.y);
+        for (size_t i = 0; i < count; i++){
+            float rgba[4];
+            memcpy(rgba, data.data() + i * sizeof(rgba), sizeof(rgba));
+            res.emplace_back(rgba[0], rgba[1], rgba[2], rgba[3]);
+        }
+        res.resize(size.x * size.y);
+        return res;
+    }
+
+    std::vector<glm::u8vec4> PixelReadback::getRawPixels() {
+        LOG_ASSERT(raw && "getRawPixels() expects a readback of RenderPass::readRawPixelsAsync()");
+        resolve();
+        std::vector<glm::u8vec4> res(size.x * size.y);
+        memcpy(res.data(), data.data(), std::min(data.size(), res.size() * sizeof(glm::u8vec4)));
+        return res;
+    }
+
+    glm::ivec2 PixelReadback::getSize() {
+        return size;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/RenderList.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/Material.hpp"
+#include "sre/Log.hpp"
+
+namespace sre {
+
+    std::shared_ptr<RenderList> RenderList::create() {
+        return std::shared_ptr<RenderList>(new RenderList());
+    }
+
+    RenderList::Handle RenderList::draw(std::shared_ptr<Mesh>& mesh, glm::mat4 modelTransform, std::shared_ptr<Material>& material, int subMesh) {
+        Handle handle;
+        if (freeHandles.empty()){
+            handle = (Handle)handleToIndex.size();
+            handleToIndex.push_back(invalidIndex);
+        } else {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        handleToIndex[handle] = (uint32_t)renderQueue.size();
+        indexToHandle.push_back(handle);
+
+        RenderPass::RenderQueueObj rqObj{mesh.get(), modelTransform, material.get(), subMesh};
+        renderQueue.push_back(rqObj);
+        precomputed.emplace_back();
+        RenderPass::precompute(renderQueue.back(), precomputed.back());
+        meshes.push_back(mesh);
+        materials.push_back(material);
+        return handle;
+    }
+
+    void RenderList::update(Handle handle, glm::mat4 modelTransform) {
+        LOG_ASSERT(isValid(handle));
+        uint32_t index = handleToIndex[handle];
+        renderQueue[index].modelTransform = modelTransform;
+        RenderPass::precompute(renderQueue[index], precomputed[index]);
+    }
+
+    void RenderList::update(Handle handle, std::shared_ptr<Material>& material) {
+        LOG_ASSERT(isValid(handle));
+        uint32_t index = handleToIndex[handle];
+        renderQueue[index].material = material.get();
+        materials[index] = material;
+        RenderPass::precompute(renderQueue[index], precomputed[index]);
+    }
+
+    void RenderList::remove(Handle handle) {
+        LOG_ASSERT(isValid(handle));
+        // move the last draw call into the removed slot
+        uint32_t index = handleToIndex[handle];
+        uint32_t last = (uint32_t)renderQueue.size() - 1;
+        if (index != last){
+            renderQueue[index] = renderQueue[last];
+            precomputed[index] = precomputed[last];
+            meshes[index] = std::move(meshes[last]);
+            materials[index] = std::move(materials[last]);
+            indexToHandle[index] = indexToHandle[last];
+            handleToIndex[indexToHandle[index]] = index;
+        }
+        renderQueue.pop_back();
+        precomputed.pop_back();
+        meshes.pop_back();
+        materials.pop_back();
+        indexToHandle.pop_back();
+        handleToIndex[handle] = invalidIndex;
+        freeHandles.push_back(handle);
+    }
+
+    bool RenderList::isValid(Handle handle) {
+        return handle < handleToIndex.size() && handleToIndex[handle] != invalidIndex;
+    }
+
+    void RenderList::clear() {
+        renderQueue.clear();
+        precomputed.clear();
+        meshes.clear();
+        materials.clear();
+        indexToHandle.clear();
+        handleToIndex.clear();
+        freeHandles.clear();
+    }
+
+    size_t RenderList::size() {
+        return renderQueue.size();
+    }
+}
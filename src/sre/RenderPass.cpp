@@ -6,14 +6,20 @@
  */
 
 #include "sre/RenderPass.hpp"
+#include "sre/RenderList.hpp"
 #include "sre/Mesh.hpp"
 #include "sre/Shader.hpp"
 #include "sre/Material.hpp"
 #include "sre/RenderStats.hpp"
 #include "sre/Texture.hpp"
 #include "sre/impl/GL.hpp"
+#include "sre/impl/NormalMatrices.hpp"
+#include "sre/impl/GeometryPool.hpp"
 #include <sre/Log.hpp>
 #include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <limits>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui_impl_opengl3.h>
 #include <imgui_impl_sdl2.h>
@@ -28,6 +34,238 @@
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        // Sort key layout (most significant bits first):
+        //   [ 2 bits bucket ][ 62 bits bucket specific ]
+        //   opaque (SortMode::StateChanges): [ 12 bits shader ][ 16 bits material ][ 16 bits mesh ][ 18 bits depth ]
+        //   opaque (SortMode::FrontToBack):  [ 18 bits depth ][ 12 bits shader ][ 16 bits material ][ 16 bits mesh ]
+        //   transparent:                     [ 18 bits inverted depth ][ 44 bits zero ] (ties keep submission order)
+        constexpr uint64_t sortKeyBucketTransparent = uint64_t(1) << 62;
+        constexpr uint64_t sortKeyShaderMask = 0xFFF;
+        constexpr uint64_t sortKeyMaterialMask = 0xFFFF;
+        constexpr uint64_t sortKeyMeshMask = 0xFFFF;
+        constexpr uint64_t sortKeyDepthMask = 0x3FFFF;
+
+        // Bounding boxes of the render queue in world space (center and half extent) stored as structure of arrays,
+        // allowing the plane tests to be vectorized
+        struct CullingData {
+            explicit CullingData(FrameArena* arena)
+            :centerX(arena), centerY(arena), centerZ(arena), extentX(arena), extentY(arena), extentZ(arena),
+             cullable(arena), outside(arena)
+            {
+            }
+            FrameVector<float> centerX, centerY, centerZ;
+            FrameVector<float> extentX, extentY, extentZ;
+            FrameVector<uint8_t> cullable;
+            FrameVector<uint8_t> outside;
+
+            void resize(size_t size){
+                centerX.resize(size); centerY.resize(size); centerZ.resize(size);
+                extentX.resize(size); extentY.resize(size); extentZ.resize(size);
+                cullable.resize(size);
+                outside.assign(size, 0);
+            }
+        };
+
+        // std140 layout of an element of the g_draws array in the g_draw_uniforms block (mat3 columns are padded to vec4)
+        struct DrawUniforms {
+            glm::mat4 model;
+            glm::vec4 modelInverseTranspose[3];
+            glm::vec4 modelViewInverseTranspose[3];
+        };
+
+        constexpr uint32_t noDrawSlot = std::numeric_limits<uint32_t>::max();  // render queue entry not using g_draw_uniforms
+
+        void writeMat3(glm::vec4* dst, const glm::mat3& m){
+            for (int c = 0; c < 3; c++){
+                dst[c] = glm::vec4(m[c], 0.0f);
+            }
+        }
+
+        // Extract the six frustum planes (Gribb/Hartmann) from a view-projection matrix.
+        // A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+        void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4* planes){
+            glm::vec4 row[4];
+            for (int i=0;i<4;i++){
+                row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+            }
+            for (int i=0;i<3;i++){
+                planes[i*2]   = row[3] + row[i];
+                planes[i*2+1] = row[3] - row[i];
+            }
+        }
+
+        // Computes the world space bounding box (center and half extent) of a draw call. Meshes without bounds,
+        // unbounded meshes (such as the blit quad) and points (where the point size is unknown) cannot be culled.
+        bool computeWorldBounds(Mesh* mesh, int subMesh, const glm::mat4& modelTransform, glm::vec3& worldCenter, glm::vec3& worldExtent){
+            auto bounds = mesh->getBoundsMinMax();
+            const glm::vec3& boundsMin = bounds[0];
+            const glm::vec3& boundsMax = bounds[1];
+            bool cullable = boundsMin.x <= boundsMax.x &&
+                            boundsMax.x - boundsMin.x < std::numeric_limits<float>::max() &&
+                            boundsMax.y - boundsMin.y < std::numeric_limits<float>::max() &&
+                            boundsMax.z - boundsMin.z < std::numeric_limits<float>::max() &&
+                            mesh->getMeshTopology(subMesh) != MeshTopology::Points;
+            if (!cullable){
+                return false;
+            }
+            glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+            glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+            const glm::mat4& m = modelTransform;
+            worldCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+            worldExtent = glm::abs(glm::vec3(m[0])) * extent.x +
+                          glm::abs(glm::vec3(m[1])) * extent.y +
+                          glm::abs(glm::vec3(m[2])) * extent.z;
+            return true;
+        }
+
+        bool isTransparent(Shader* shader){
+            return shader->getBlend() != BlendType::Disabled || !shader->isDepthWrite();
+        }
+
+        // shader, material and mesh part of an opaque sort key (44 bits). The ids only group draw calls: they are
+        // truncated (and mesh ids wrap around), so state is never skipped based on the key
+        uint64_t computeStateKey(long shaderUniqueId, uint16_t materialId, uint16_t meshId){
+            return (((uint64_t)shaderUniqueId & sortKeyShaderMask) << 32) |
+                   (((uint64_t)materialId & sortKeyMaterialMask) << 16) |
+                   ((uint64_t)meshId & sortKeyMeshMask);
+        }
+
+        // Identifies a draw call across frames using the mesh, material and the position of the bounds (quantized
+        // relative to their size). Objects moving more than a fraction of their size get a new key (and are treated as
+        // visible)
+        uint64_t occlusionKey(uint64_t passKey, uint16_t meshId, uint16_t materialId, int subMesh, const glm::vec3& worldCenter, const glm::vec3& worldExtent){
+            float cellSize = std::max(std::max(worldExtent.x, worldExtent.y), std::max(worldExtent.z, 1e-3f)) * 0.25f;
+            glm::vec3 cell = glm::floor(worldCenter / cellSize);
+            uint64_t values[] = {meshId, materialId, (uint64_t)subMesh,
+                                 (uint64_t)(uint32_t)(int32_t)cell.x, (uint64_t)(uint32_t)(int32_t)cell.y, (uint64_t)(uint32_t)(int32_t)cell.z};
+            uint64_t key = passKey;
+            for (auto value : values){
+                key = (key ^ value) * 1099511628211ull; // FNV-1a style
+            }
+            return key;
+        }
+
+        // center of the mesh bounds (or the origin if the mesh has no bounds)
+        glm::vec3 boundsCenter(Mesh* mesh){
+            auto bounds = mesh->getBoundsMinMax();
+            if (bounds[0].x <= bounds[1].x){
+                return (bounds[0] + bounds[1]) * 0.5f;
+            }
+            return glm::vec3{0.0f};
+        }
+
+        bool isOutsideFrustum(const glm::vec4* planes, const glm::vec3& center, const glm::vec3& extent){
+            for (int p=0;p<6;p++){
+                float distance = glm::dot(glm::vec3(planes[p]), center) + planes[p].w;
+                float radius = glm::dot(glm::abs(glm::vec3(planes[p])), extent);
+                if (distance + radius < 0.0f){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template<typename T>
+        void keepAlive(FrameVector<std::shared_ptr<T>>& inUse, const std::shared_ptr<T>& ptr){
+            // consecutive draw calls often use the same mesh or material, so only changes are recorded
+            if (inUse.empty() || inUse.back() != ptr){
+                inUse.push_back(ptr);
+            }
+        }
+
+        // Marks the boxes which are completely on the negative side of one of the planes
+        void testFrustumPlanes(CullingData& data, const glm::vec4* planes){
+            const size_t size = data.outside.size();
+            const float* cx = data.centerX.data();
+            const float* cy = data.centerY.data();
+            const float* cz = data.centerZ.data();
+            const float* ex = data.extentX.data();
+            const float* ey = data.extentY.data();
+            const float* ez = data.extentZ.data();
+            uint8_t* outside = data.outside.data();
+            for (int p=0;p<6;p++){
+                const float px = planes[p].x, py = planes[p].y, pz = planes[p].z, pw = planes[p].w;
+                const float ax = std::abs(px), ay = std::abs(py), az = std::abs(pz);
+                for (size_t i=0;i<size;i++){
+                    float distance = px*cx[i] + py*cy[i] + pz*cz[i] + pw;
+                    float radius = ax*ex[i] + ay*ey[i] + az*ez[i];
+                    outside[i] |= (uint8_t)(distance + radius < 0.0f);
+                }
+            }
+        }
+
+        // Per-instance data streamed to the instance buffer (matches g_instance_model and g_instance_model_it)
+        struct InstanceData {
+            glm::mat4 model;
+            glm::mat3 modelInverseTranspose;
+        };
+
+        // Consecutive draw calls rendered using a single instanced draw call (or a single multi draw call when the
+        // meshes differ, but share a geometry pool)
+        struct InstanceRun {
+            size_t first;                   // index in render queue
+            int count;
+            size_t firstInstance;           // index in instance buffer
+            size_t firstCommand = 0;        // index in multi draw commands
+            int commandCount = 0;           // 0 if not a multi draw call
+        };
+
+        // command layout of glMultiDrawElementsIndirect()
+        struct DrawElementsIndirectCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;            // relative to the instance attribute pointers of the run
+        };
+
+        struct SortItem {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        // Quantize a non-negative view depth to 18 bits. The bits of a positive IEEE float are monotonic with
+        // its value, so the exponent and the upper mantissa bits gives a logarithmic quantization without
+        // knowing the depth range of the camera.
+        uint64_t quantizeDepth(float depth){
+            if (!(depth > 0.0f)){
+                return 0;
+            }
+            uint32_t bits;
+            memcpy(&bits, &depth, sizeof(float));
+            return (bits >> 13) & sortKeyDepthMask;
+        }
+
+        // Stable LSD radix sort (8 bits per pass). Passes where all keys share the same digit are skipped.
+        void radixSort(FrameVector<SortItem>& items, FrameVector<SortItem>& tmp){
+            if (items.size() < 2){
+                return;
+            }
+            tmp.resize(items.size());
+            for (int shift = 0; shift < 64; shift += 8) {
+                size_t count[256] = {0};
+                for (auto& item : items){
+                    count[(item.key >> shift) & 0xFF]++;
+                }
+                if (count[(items[0].key >> shift) & 0xFF] == items.size()){
+                    continue;
+                }
+                size_t offset = 0;
+                for (auto& c : count){
+                    size_t n = c;
+                    c = offset;
+                    offset += n;
+                }
+                for (auto& item : items){
+                    tmp[count[(item.key >> shift) & 0xFF]++] = item;
+                }
+                items.swap(tmp);
+            }
+        }
+    }
+
     // declare static variable
     RenderPass::FrameInspector RenderPass::frameInspector;
 
@@ -105,8 +343,38 @@ namespace sre {
         return *this;
     }
 
+    RenderPass::RenderPassBuilder & RenderPass::RenderPassBuilder::withFrustumCulling(bool enabled) {
+        this->frustumCulling = enabled;
+        return *this;
+    }
+
+    RenderPass::RenderPassBuilder & RenderPass::RenderPassBuilder::withDepthPrepass(bool enabled) {
+        this->depthPrepass = enabled;
+        return *this;
+    }
+
+    RenderPass::RenderPassBuilder & RenderPass::RenderPassBuilder::withOcclusionCulling(bool enabled) {
+        this->occlusionCulling = enabled;
+        return *this;
+    }
+
+    RenderPass::RenderPassBuilder & RenderPass::RenderPassBuilder::withSortMode(SortMode sortMode) {
+        this->sortMode = sortMode;
+        return *this;
+    }
+
     RenderPass::RenderPass(RenderPass::RenderPassBuilder& builder)
-        :builder(builder)
+        :renderQueue(&Renderer::instance->frameArena),
+         meshesInUse(&Renderer::instance->frameArena),
+         materialsInUse(&Renderer::instance->frameArena),
+         renderLists(&Renderer::instance->frameArena),
+         debugPoints(&Renderer::instance->frameArena),
+         debugLines(&Renderer::instance->frameArena),
+         debugTriangles(&Renderer::instance->frameArena),
+         normalMatrices(&Renderer::instance->frameArena),
+         occlusionQueries(&Renderer::instance->frameArena),
+         drawSlots(&Renderer::instance->frameArena),
+         builder(builder)
     {
         if (builder.gui) {
             ImGui_ImplOpenGL3_NewFrame();
@@ -123,10 +391,25 @@ namespace sre {
         std::swap(mIsFinished,rp.mIsFinished);
         std::swap(lastBoundShader,rp.lastBoundShader);
         std::swap(lastBoundMaterial,rp.lastBoundMaterial);
-        std::swap(lastBoundMeshId,rp.lastBoundMeshId);
+        std::swap(lastBoundMesh,rp.lastBoundMesh);
         std::swap(projection,rp.projection);
+        std::swap(drawUniformsOffset,rp.drawUniformsOffset);
+        std::swap(drawUniformsRangeSize,rp.drawUniformsRangeSize);
+        std::swap(boundDrawUniformsRange,rp.boundDrawUniformsRange);
         std::swap(viewportOffset,rp.viewportOffset);
         std::swap(viewportSize,rp.viewportSize);
+        renderQueue.swap(rp.renderQueue);
+        meshesInUse.swap(rp.meshesInUse);
+        materialsInUse.swap(rp.materialsInUse);
+        std::swap(instancedDraws,rp.instancedDraws);
+        std::swap(recorders,rp.recorders);
+        renderLists.swap(rp.renderLists);
+        normalMatrices.swap(rp.normalMatrices);
+        occlusionQueries.swap(rp.occlusionQueries);
+        drawSlots.swap(rp.drawSlots);
+        debugPoints.swap(rp.debugPoints);
+        debugLines.swap(rp.debugLines);
+        debugTriangles.swap(rp.debugTriangles);
     }
 
     RenderPass::~RenderPass(){
@@ -135,7 +418,103 @@ namespace sre {
 
     void RenderPass::draw(std::shared_ptr<Mesh>& meshPtr, glm::mat4 modelTransform, std::shared_ptr<Material>& material_ptr) {
         LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
-        renderQueue.emplace_back(RenderQueueObj{meshPtr, modelTransform, material_ptr});
+        keepAlive(meshPtr, material_ptr);
+        renderQueue.push_back({meshPtr.get(), modelTransform, material_ptr.get()});
+    }
+
+    void RenderPass::keepAlive(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material) {
+        sre::keepAlive(meshesInUse, mesh);
+        sre::keepAlive(materialsInUse, material);
+    }
+
+    std::shared_ptr<RenderPass::Recorder> RenderPass::createRecorder() {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        auto recorder = std::shared_ptr<Recorder>(new Recorder());
+        recorder->frustumCulling = builder.frustumCulling;
+        if (builder.frustumCulling){
+            // same projection as used in finish()
+            auto size = static_cast<glm::uvec2>(frameSize() * builder.camera.viewportSize);
+            extractFrustumPlanes(builder.camera.getProjectionTransform(size) * builder.camera.viewTransform, recorder->frustumPlanes);
+        }
+        recorders.push_back(recorder);
+        return recorder;
+    }
+
+    void RenderPass::mergeRecorders() {
+        for (auto& recorder : recorders){
+            recorder->finished = true;
+            builder.renderStats->objectsSubmitted += recorder->objectsSubmitted;
+            builder.renderStats->objectsCulled += recorder->objectsCulled;
+            builder.renderStats->objectsDrawn += (int)recorder->renderQueue.size();
+            renderQueue.reserve(renderQueue.size() + recorder->renderQueue.size());
+            for (auto& rqObj : recorder->renderQueue){
+                renderQueue.push_back(rqObj);
+            }
+        }
+    }
+
+    void RenderPass::draw(std::shared_ptr<RenderList>& renderList) {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        renderLists.push_back(renderList);
+    }
+
+    void RenderPass::mergeRenderLists() {
+        size_t size = renderQueue.size();
+        for (auto& renderList : renderLists){
+            size += renderList->renderQueue.size();
+        }
+        renderQueue.reserve(size);
+        for (auto& renderList : renderLists){
+            for (size_t i = 0; i < renderList->renderQueue.size(); i++){
+                renderQueue.push_back(renderList->renderQueue[i]);
+                renderQueue.back().precomputed = &renderList->precomputed[i];
+            }
+        }
+    }
+
+    void RenderPass::precompute(const RenderQueueObj& rqObj, PrecomputedObj& precomputed) {
+        Shader* shader = rqObj.material->shader.get();
+        precomputed.modelInverseTranspose = glm::transpose(glm::inverse((glm::mat3)rqObj.modelTransform));
+        precomputed.cullable = computeWorldBounds(rqObj.mesh, rqObj.subMesh, rqObj.modelTransform, precomputed.worldCenter, precomputed.worldExtent);
+        if (!precomputed.cullable){
+            precomputed.worldCenter = glm::vec3(rqObj.modelTransform * glm::vec4(boundsCenter(rqObj.mesh), 1.0f));
+            precomputed.worldExtent = glm::vec3{0.0f};
+        }
+        precomputed.transparent = isTransparent(shader);
+        precomputed.stateKey = computeStateKey(shader->shaderUniqueId, rqObj.material->materialId, rqObj.mesh->meshId);
+    }
+
+    void RenderPass::Recorder::draw(std::shared_ptr<Mesh>& meshPtr, glm::mat4 modelTransform, std::shared_ptr<Material>& material_ptr) {
+        LOG_ASSERT(!finished && "RenderPass is finished. Can no longer be modified.");
+        objectsSubmitted++;
+        glm::vec3 worldCenter, worldExtent;
+        if (frustumCulling && computeWorldBounds(meshPtr.get(), 0, modelTransform, worldCenter, worldExtent) &&
+            isOutsideFrustum(frustumPlanes, worldCenter, worldExtent)){
+            objectsCulled++;
+            return;
+        }
+        sre::keepAlive(meshesInUse, meshPtr);
+        sre::keepAlive(materialsInUse, material_ptr);
+        renderQueue.push_back({meshPtr.get(), modelTransform, material_ptr.get()});
+    }
+
+    void RenderPass::Recorder::draw(std::shared_ptr<Mesh>& meshPtr, glm::mat4 modelTransform, std::vector<std::shared_ptr<Material>> materials) {
+        LOG_ASSERT(!finished && "RenderPass is finished. Can no longer be modified.");
+        LOG_ASSERT(meshPtr->elementBufferOffsetCount.size() == 0 || meshPtr->elementBufferOffsetCount.size() == materials.size());
+        int subMesh = 0;
+        for (auto & mat : materials){
+            objectsSubmitted++;
+            glm::vec3 worldCenter, worldExtent;
+            if (frustumCulling && computeWorldBounds(meshPtr.get(), subMesh, modelTransform, worldCenter, worldExtent) &&
+                isOutsideFrustum(frustumPlanes, worldCenter, worldExtent)){
+                objectsCulled++;
+            } else {
+                sre::keepAlive(meshesInUse, meshPtr);
+                sre::keepAlive(materialsInUse, mat);
+                renderQueue.push_back({meshPtr.get(), modelTransform, mat.get(), subMesh});
+            }
+            subMesh++;
+        }
     }
 
     void RenderPass::setupShaderRenderPass(Shader *shader){
@@ -182,83 +561,272 @@ namespace sre {
                 globalUniforms.g_lightColorRange[i] = glm::vec4(light->color, light->range);
             }
         }
-        glBindBuffer(GL_UNIFORM_BUFFER, Renderer::instance->globalUniformBuffer);
-        glBufferData(GL_UNIFORM_BUFFER, Renderer::instance->globalUniformBufferSize, globalUniforms.g_view, GL_STREAM_DRAW);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        auto renderer = Renderer::instance;
+        size_t offset = renderer->globalUniforms.write(globalUniforms.g_view, renderer->globalUniformBufferSize, builder.renderStats->frame);
+        glBindBufferRange(GL_UNIFORM_BUFFER, Shader::globalUniformBindingIndex, renderer->globalUniforms.getBuffer(), offset, renderer->globalUniformBufferSize);
     }
 
-    void RenderPass::setupShader(const glm::mat4 &modelTransform, Shader *shader)  {
+    void RenderPass::setupShader(const glm::mat4 &modelTransform, Shader *shader, const glm::mat3* modelInverseTranspose, size_t drawIndex)  {
         if (lastBoundShader != shader){
             builder.renderStats->stateChangesShader++;
             lastBoundShader = shader;
             shader->bind();
         }
+        if (shader->drawUniformBlock){
+            // the transforms are already in the draw uniform buffer (see writeDrawUniforms())
+            LOG_ASSERT(drawIndex < drawSlots.size() && drawSlots[drawIndex] != noDrawSlot);
+            uint32_t slot = drawSlots[drawIndex];
+            int64_t range = slot / Shader::drawUniformBlockDraws;
+            if (range != boundDrawUniformsRange){
+                boundDrawUniformsRange = range;
+                glBindBufferRange(GL_UNIFORM_BUFFER, Shader::drawUniformBindingIndex, Renderer::instance->drawUniforms.getBuffer(),
+                                  drawUniformsOffset + drawUniformsRangeSize * range, drawUniformsRangeSize);
+            }
+            if (shader->uniformLocationDrawIndex != -1){
+                glUniform1i(shader->uniformLocationDrawIndex, (GLint)(slot % Shader::drawUniformBlockDraws));
+            }
+            return;
+        }
         if (shader->uniformLocationModel != -1){
             glUniformMatrix4fv(shader->uniformLocationModel, 1, GL_FALSE, glm::value_ptr(modelTransform));
         }
+        if (shader->uniformLocationModelViewInverseTranspose == -1 && shader->uniformLocationModelInverseTranspose == -1){
+            return;
+        }
+        glm::mat3 normalMatrix;
+        if (modelInverseTranspose == nullptr){
+            normalMatrix = transpose(inverse((glm::mat3)modelTransform));
+            modelInverseTranspose = &normalMatrix;
+        }
         if (shader->uniformLocationModelViewInverseTranspose != -1){
-            auto normalMatrix = transpose(inverse(((glm::mat3)builder.camera.getViewTransform()) * ((glm::mat3)modelTransform)));
-            glUniformMatrix3fv(shader->uniformLocationModelViewInverseTranspose, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+            // transpose(inverse(V*M)) = transpose(inverse(V)) * transpose(inverse(M))
+            auto modelViewInverseTranspose = viewInverseTranspose * (*modelInverseTranspose);
+            glUniformMatrix3fv(shader->uniformLocationModelViewInverseTranspose, 1, GL_FALSE, glm::value_ptr(modelViewInverseTranspose));
         }
         if (shader->uniformLocationModelInverseTranspose != -1){
-            auto normalMatrix = transpose(inverse((glm::mat3)modelTransform));
-            glUniformMatrix3fv(shader->uniformLocationModelInverseTranspose, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+            glUniformMatrix3fv(shader->uniformLocationModelInverseTranspose, 1, GL_FALSE, glm::value_ptr(*modelInverseTranspose));
         }
     }
 
     void RenderPass::drawLines(const std::vector<glm::vec3> &verts, Color color, MeshTopology meshTopology) {
+        glm::vec4 linearColor = color.toLinear();
+        addDebugGeometry(verts, &linearColor, false, meshTopology);
+    }
+
+    void RenderPass::drawLines(const std::vector<glm::vec3> &verts, const std::vector<Color> &colors, MeshTopology meshTopology) {
+        LOG_ASSERT(verts.size() == colors.size() && "drawLines() expects a color per vertex");
+        std::vector<glm::vec4> linearColors;
+        linearColors.reserve(colors.size());
+        for (auto c : colors){
+            linearColors.push_back(c.toLinear());
+        }
+        addDebugGeometry(verts, linearColors.data(), true, meshTopology);
+    }
+
+    void RenderPass::drawLine(glm::vec3 from, glm::vec3 to, Color color) {
+        drawLine(from, to, color, color);
+    }
+
+    void RenderPass::drawLine(glm::vec3 from, glm::vec3 to, Color colorFrom, Color colorTo) {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        debugLines.push_back({from, colorFrom.toLinear()});
+        debugLines.push_back({to, colorTo.toLinear()});
+    }
+
+    void RenderPass::drawPoint(glm::vec3 position, Color color) {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        debugPoints.push_back({position, color.toLinear()});
+    }
+
+    void RenderPass::drawTriangle(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, Color color) {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        glm::vec4 linearColor = color.toLinear();
+        debugTriangles.push_back({p0, linearColor});
+        debugTriangles.push_back({p1, linearColor});
+        debugTriangles.push_back({p2, linearColor});
+    }
+
+    void RenderPass::drawWireBox(glm::vec3 min, glm::vec3 max, Color color, const glm::mat4& transform) {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        glm::vec4 linearColor = color.toLinear();
+        glm::vec3 corners[8];
+        for (int i = 0; i < 8; i++){
+            glm::vec3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+            corners[i] = glm::vec3(transform * glm::vec4(corner, 1.0f));
+        }
+        // each edge connects two corners differing in one bit
+        for (int i = 0; i < 8; i++){
+            for (int bit = 1; bit < 8; bit <<= 1){
+                if ((i & bit) == 0){
+                    debugLines.push_back({corners[i], linearColor});
+                    debugLines.push_back({corners[i | bit], linearColor});
+                }
+            }
+        }
+    }
+
+    void RenderPass::addDebugGeometry(const std::vector<glm::vec3>& verts, const glm::vec4* colors, bool colorPerVertex, MeshTopology meshTopology) {
         LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        auto vertex = [&](size_t i){
+            return DebugVertex{verts[i], colors[colorPerVertex ? i : 0]};
+        };
+        size_t count = verts.size();
+        switch (meshTopology){
+            case MeshTopology::Points:
+                for (size_t i = 0; i < count; i++){
+                    debugPoints.push_back(vertex(i));
+                }
+                break;
+            case MeshTopology::Lines:
+                for (size_t i = 0; i + 1 < count; i += 2){
+                    debugLines.push_back(vertex(i));
+                    debugLines.push_back(vertex(i + 1));
+                }
+                break;
+            case MeshTopology::LineStrip:
+                for (size_t i = 0; i + 1 < count; i++){
+                    debugLines.push_back(vertex(i));
+                    debugLines.push_back(vertex(i + 1));
+                }
+                break;
+            case MeshTopology::Triangles:
+                for (size_t i = 0; i + 2 < count; i += 3){
+                    debugTriangles.push_back(vertex(i));
+                    debugTriangles.push_back(vertex(i + 1));
+                    debugTriangles.push_back(vertex(i + 2));
+                }
+                break;
+            case MeshTopology::TriangleStrip:
+                for (size_t i = 0; i + 2 < count; i++){
+                    // keep the winding order of odd triangles
+                    debugTriangles.push_back(vertex(i % 2 == 0 ? i : i + 1));
+                    debugTriangles.push_back(vertex(i % 2 == 0 ? i + 1 : i));
+                    debugTriangles.push_back(vertex(i + 2));
+                }
+                break;
+            case MeshTopology::TriangleFan:
+                for (size_t i = 1; i + 1 < count; i++){
+                    debugTriangles.push_back(vertex(0));
+                    debugTriangles.push_back(vertex(i));
+                    debugTriangles.push_back(vertex(i + 1));
+                }
+                break;
+        }
+    }
 
-        // Keep a shared mesh and material
-        auto material = Shader::getUnlit()->createMaterial();
-        auto mesh = Mesh::create()
-                .withPositions(verts)
-                .withMeshTopology(meshTopology)
-                .build();
+    bool RenderPass::hasDebugGeometry() {
+        return !debugPoints.empty() || !debugLines.empty() || !debugTriangles.empty();
+    }
 
-        // update material
-        material->setColor(color);
+    void RenderPass::drawDebugGeometry() {
+        if (!hasDebugGeometry()){
+            return;
+        }
+        auto renderer = Renderer::instance;
+        Material* material = renderer->debugMaterial.get();
+        Shader* shader = material->shader.get();
+
+        // stream the vertices [points][lines][triangles] (orphaning the previous buffer)
+        FrameVector<DebugVertex>* lists[] = {&debugPoints, &debugLines, &debugTriangles};
+        GLenum modes[] = {GL_POINTS, GL_LINES, GL_TRIANGLES};
+        size_t size = sizeof(DebugVertex) * (debugPoints.size() + debugLines.size() + debugTriangles.size());
+        if (renderer->debugVertexBuffer == 0){
+            glGenBuffers(1, &renderer->debugVertexBuffer);
+            if (renderInfo().graphicsAPIVersionMajor >= 3){
+                glGenVertexArrays(1, &renderer->debugVertexArray);
+            }
+        }
+        if (size > renderer->debugVertexBufferSize){
+            renderer->debugVertexBufferSize = std::max(size, renderer->debugVertexBufferSize * 2);
+        }
+        if (renderer->debugVertexArray != 0){
+            glBindVertexArray(renderer->debugVertexArray);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, renderer->debugVertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, renderer->debugVertexBufferSize, nullptr, GL_STREAM_DRAW);
+        size_t offset = 0;
+        for (auto list : lists){
+            glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(DebugVertex) * list->size(), list->data());
+            offset += sizeof(DebugVertex) * list->size();
+        }
 
-        renderQueue.emplace_back(RenderQueueObj{
-                                         mesh,
-                                         glm::mat4(1),
-                                         material
-                                 });
+        static const glm::mat3 identity(1);
+        setupShader(glm::mat4(1), shader, &identity, renderQueue.size());
+        if (material != lastBoundMaterial){
+            builder.renderStats->stateChangesMaterial++;
+            lastBoundMaterial = material;
+            material->bind();
+        }
+        builder.renderStats->stateChangesMesh++;
+        lastBoundMesh = nullptr;
+        for (auto& attribute : shader->attributes){
+            GLuint location = (GLuint)attribute.second.position;
+            if (attribute.first == "position"){
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), BUFFER_OFFSET(offsetof(DebugVertex, position)));
+            } else if (attribute.first == "vertex_color"){
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), BUFFER_OFFSET(offsetof(DebugVertex, color)));
+            } else {
+                static const float zero[] = {0, 0, 0, 0};
+                glDisableVertexAttribArray(location);
+                glVertexAttrib4fv(location, zero);
+            }
+        }
+#ifndef __APPLE__
+        glLineWidth(1);
+#endif
+        GLint first = 0;
+        for (int i = 0; i < 3; i++){
+            if (!lists[i]->empty()){
+                builder.renderStats->drawCalls++;
+                glDrawArrays(modes[i], first, (GLsizei)lists[i]->size());
+            }
+            first += (GLint)lists[i]->size();
+        }
     }
 
     void RenderPass::setupGlobalShaderUniforms(){
-        static std::vector<char> buffer;
-        static GlobalUniforms globalUniforms;
-        static bool once = [&](){
-            // allocate buffer and setup pointers into buffer
-            buffer.resize(Renderer::instance->globalUniformBufferSize, 0);
-            globalUniforms.g_view = reinterpret_cast<glm::mat4 *>(buffer.data());
-            globalUniforms.g_projection = reinterpret_cast<glm::mat4 *>(buffer.data() + sizeof(glm::mat4));
-            globalUniforms.g_viewport = reinterpret_cast<glm::vec4 *>(buffer.data() + sizeof(glm::mat4)*2);
-            globalUniforms.g_cameraPos = reinterpret_cast<glm::vec4 *>(buffer.data() + sizeof(glm::mat4)*2 + sizeof(glm::vec4));
-            globalUniforms.g_ambientLight = reinterpret_cast<glm::vec4 *>(buffer.data() + sizeof(glm::mat4)*2 + sizeof(glm::vec4)*2);
+        auto& rinfo = renderInfo();
+        if (Renderer::instance->globalUniforms.getBuffer()){
+            // allocate the block in the frame arena and setup pointers into it (the block size is a multiple of vec4)
+            FrameVector<glm::vec4> block(&Renderer::instance->frameArena);
+            block.resize(Renderer::instance->globalUniformBufferSize / sizeof(glm::vec4), glm::vec4(0));
+            char* buffer = reinterpret_cast<char*>(block.data());
+            GlobalUniforms globalUniforms;
+            globalUniforms.g_view = reinterpret_cast<glm::mat4 *>(buffer);
+            globalUniforms.g_projection = reinterpret_cast<glm::mat4 *>(buffer + sizeof(glm::mat4));
+            globalUniforms.g_viewport = reinterpret_cast<glm::vec4 *>(buffer + sizeof(glm::mat4)*2);
+            globalUniforms.g_cameraPos = reinterpret_cast<glm::vec4 *>(buffer + sizeof(glm::mat4)*2 + sizeof(glm::vec4));
+            globalUniforms.g_ambientLight = reinterpret_cast<glm::vec4 *>(buffer + sizeof(glm::mat4)*2 + sizeof(glm::vec4)*2);
             int lightColorRangeOffset = sizeof(glm::mat4)*2 + sizeof(glm::vec4)*3;
-            globalUniforms.g_lightColorRange = reinterpret_cast<glm::vec4*>(buffer.data() + lightColorRangeOffset);
+            globalUniforms.g_lightColorRange = reinterpret_cast<glm::vec4*>(buffer + lightColorRangeOffset);
             int g_lightPosTypeOffset = lightColorRangeOffset+ sizeof(glm::vec4)*(Renderer::instance->maxSceneLights);
-            globalUniforms.g_lightPosType = reinterpret_cast<glm::vec4*>(buffer.data() + g_lightPosTypeOffset );
-            return true;
-        } ();
-        auto& rinfo = renderInfo();
-        if (Renderer::instance->globalUniformBuffer){
+            globalUniforms.g_lightPosType = reinterpret_cast<glm::vec4*>(buffer + g_lightPosTypeOffset );
             setupShaderRenderPass(globalUniforms);
         } else {
             // find list of used shaders
             std::set<Shader*> shaders;
 
             for (auto &rqObj : renderQueue) {
-                LOG_ASSERT(rqObj.material.get());
-                LOG_ASSERT(rqObj.material->getShader().get());
-                LOG_ASSERT(rqObj.mesh.get());
-                shaders.insert(rqObj.material->getShader().get());
+                LOG_ASSERT(rqObj.material);
+                LOG_ASSERT(rqObj.material->shader.get());
+                LOG_ASSERT(rqObj.mesh);
+                shaders.insert(rqObj.material->shader.get());
+            }
+            if (hasDebugGeometry()){
+                shaders.insert(Renderer::instance->debugMaterial->shader.get());
+            }
+            if (builder.depthPrepass){
+                for (auto& rqObj : renderQueue){
+                    if (auto depthShader = depthPrepassShader(rqObj)){
+                        shaders.insert(depthShader);
+                    }
+                }
             }
             // update global uniforms
             for (auto shader : shaders){
-                glUseProgram(shader->shaderProgramId);
+                Renderer::instance->glState.useProgram(shader->shaderProgramId);
                 setupShaderRenderPass(shader);
             }
         }
@@ -276,71 +844,86 @@ namespace sre {
         if (mIsFinished){
             return;
         }
+        Renderer::instance->beginGpuTimer(builder.name);
+        auto& glState = Renderer::instance->glState;
         if (builder.framebuffer!=nullptr){
             builder.framebuffer->bind();
         } else {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glState.bindFramebuffer(0);
         }
 
         glm::vec2 windowSize = frameSize();
         viewportOffset = static_cast<glm::uvec2>(builder.camera.viewportOffset * windowSize);
         viewportSize = static_cast<glm::uvec2>(windowSize * builder.camera.viewportSize);
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
-        glViewport(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
+        glState.setEnabled(GLState::Capability::ScissorTest, true);
+        glState.scissor(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
+        glState.viewport(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
 
         GLbitfield clear = 0;
         if (builder.clearColor) {
             glClearColor(builder.clearColorValue.r, builder.clearColorValue.g, builder.clearColorValue.b, builder.clearColorValue.a);
             clear |= GL_COLOR_BUFFER_BIT;
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glState.colorMask(true, true, true, true);
         }
         if (builder.clearDepth) {
             glClearDepthf(builder.clearDepthValue);
-            glDepthMask(GL_TRUE);
             clear |= GL_DEPTH_BUFFER_BIT;
-            glDepthMask(GL_TRUE);
+            glState.depthMask(true);
         }
         if (builder.clearStencil) {
             glClearStencil(builder.clearStencilValue);
             clear |= GL_STENCIL_BUFFER_BIT;
-            glStencilMask(0xFFFF);
+            glState.stencilMask(0xFFFF);
         }
         if (clear != 0u) {
             glClear(clear);
         }
 
         projection = builder.camera.getProjectionTransform(viewportSize);
+        viewInverseTranspose = glm::transpose(glm::inverse((glm::mat3)builder.camera.viewTransform));
 
         if (builder.skybox) {
             // Create an infinite projection
             glm::mat4 inf = builder.camera.getInfiniteProjectionTransform(viewportSize);
-            renderQueue[0] = {builder.skybox->skyboxMesh,
+            renderQueue[0] = {builder.skybox->skyboxMesh.get(),
                                 inf, // passing the inf projection as the model matrix
-                                builder.skybox->material};
+                                builder.skybox->material.get()};
+        }
+
+        // draw calls are rendered in this order (unless sorted): the draw calls of the renderpass, of the recorders and
+        // of the render lists. Recorders cull while recording and the skybox (if any) is never culled
+        cullRenderQueue(builder.skybox ? 1 : 0);
+        mergeRecorders();
+        size_t firstRenderListObj = renderQueue.size();
+        mergeRenderLists();
+        cullRenderQueue(firstRenderListObj);
+        sortRenderQueue();
+        computeNormalMatrices();
+        if (hasDebugGeometry() && !Renderer::instance->debugMaterial){
+            Renderer::instance->debugMaterial = Shader::getUnlit()->createMaterial({{"S_VERTEX_COLOR","1"}});
         }
 
         setupGlobalShaderUniforms();
 
-        for (auto & rqObj : renderQueue){
-            drawInstance(rqObj);
-        }
+        drawRenderQueue();
+        drawDebugGeometry();
 
         if (builder.gui) {
             if (builder.drawImGuiArrowMouseCursor) drawImGuiArrowMousCursor();
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glState.bindFramebuffer(0);
         if (builder.framebuffer != nullptr){
             for(auto& tex : builder.framebuffer->textures){
                 if (tex->generateMipmap){
-                    glBindTexture(tex->target,tex->textureId);
+                    glState.bindTexture(0, tex->target, tex->textureId);
                     glGenerateMipmap(tex->target);
-                    glBindTexture(tex->target,0);
+                    glState.bindTexture(0, tex->target, 0);
                 }
             }
         }
+        Renderer::instance->endGpuTimer();
         mIsFinished = true;
 #ifndef NDEBUG
         checkGLError("RenderPass");
@@ -354,7 +937,7 @@ namespace sre {
     std::vector<Color> RenderPass::readPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen) {
         LOG_ASSERT(mIsFinished);
         if (readFromScreen) {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            Renderer::instance->glState.bindFramebuffer(0);
         } else if (builder.framebuffer!=nullptr){
             builder.framebuffer->bind();
         }
@@ -364,7 +947,7 @@ namespace sre {
 
         // set default framebuffer
         if (!readFromScreen && builder.framebuffer!=nullptr) {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            Renderer::instance->glState.bindFramebuffer(0);
         }
 
         return res;
@@ -373,7 +956,7 @@ namespace sre {
     std::vector<glm::u8vec4> RenderPass::readRawPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen) {
         LOG_ASSERT(mIsFinished);
         if (readFromScreen) {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            Renderer::instance->glState.bindFramebuffer(0);
         } else if (builder.framebuffer!=nullptr){
             builder.framebuffer->bind();
         }
@@ -383,51 +966,683 @@ namespace sre {
 
         // set default framebuffer
         if (!readFromScreen && builder.framebuffer!=nullptr) {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            Renderer::instance->glState.bindFramebuffer(0);
         }
 
         return bytes;
     }
 
+    std::shared_ptr<PixelReadback> RenderPass::readPixelsAsync(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen) {
+        return readAsync(x, y, width, height, readFromScreen, false);
+    }
+
+    std::shared_ptr<PixelReadback> RenderPass::readRawPixelsAsync(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen) {
+        return readAsync(x, y, width, height, readFromScreen, true);
+    }
+
+    std::shared_ptr<PixelReadback> RenderPass::readAsync(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen, bool raw) {
+        LOG_ASSERT(mIsFinished);
+        if (readFromScreen) {
+            Renderer::instance->glState.bindFramebuffer(0);
+        } else if (builder.framebuffer!=nullptr){
+            builder.framebuffer->bind();
+        }
+        auto res = std::shared_ptr<PixelReadback>(new PixelReadback(glm::ivec2(width, height), raw));
+        res->read(x, y);
+
+        // set default framebuffer
+        if (!readFromScreen && builder.framebuffer!=nullptr) {
+            Renderer::instance->glState.bindFramebuffer(0);
+        }
+
+        return res;
+    }
+
     void RenderPass::draw(std::shared_ptr<Mesh> &meshPtr, glm::mat4 modelTransform,
                           std::vector<std::shared_ptr<Material>> materials) {
         LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
-        LOG_ASSERT(meshPtr->indices.size() == 0 || meshPtr->indices.size() == materials.size());
+        LOG_ASSERT(meshPtr->elementBufferOffsetCount.size() == 0 || meshPtr->elementBufferOffsetCount.size() == materials.size());
         int subMesh = 0;
         for (auto & mat : materials){
-            renderQueue.emplace_back(RenderQueueObj{meshPtr, modelTransform, mat,subMesh});
+            keepAlive(meshPtr, mat);
+            renderQueue.push_back({meshPtr.get(), modelTransform, mat.get(), subMesh});
             subMesh++;
         }
     }
 
-    void RenderPass::drawInstance(RenderQueueObj& rqObj) {
+    void RenderPass::drawInstanced(std::shared_ptr<Mesh>& meshPtr, const glm::mat4* modelTransforms, size_t count, std::shared_ptr<Material>& material_ptr) {
+        drawInstanced(meshPtr, modelTransforms, count, material_ptr, {});
+    }
+
+    void RenderPass::drawInstanced(std::shared_ptr<Mesh>& meshPtr, const glm::mat4* modelTransforms, size_t count, std::shared_ptr<Material>& material_ptr,
+                                   const std::map<std::string, const glm::vec4*>& instanceAttributes) {
+        LOG_ASSERT(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        if (count == 0){
+            return;
+        }
+        auto shader = material_ptr->getShader();
+        if (!shader->isInstanced()){
+            // fallback when instancing is not supported (or the shader is not instanced)
+            LOG_WARNING("drawInstanced() expects a shader with the S_INSTANCED specialization. Drawing each instance using draw().");
+            for (size_t i = 0; i < count; i++){
+                draw(meshPtr, modelTransforms[i], material_ptr);
+            }
+            return;
+        }
+        InstancedDraw instancedDraw{modelTransforms, count};
+        for (auto& attribute : instanceAttributes){
+            auto shaderAttribute = shader->attributes.find(attribute.first);
+            if (shaderAttribute == shader->attributes.end()){
+                continue; // attribute not used by shader
+            }
+            if (shaderAttribute->second.type != GL_FLOAT_VEC4 || meshPtr->attributeByName.find(attribute.first) != meshPtr->attributeByName.end()){
+                LOG_ERROR("Instance attribute %s must be a vec4 shader attribute not defined in the mesh.", attribute.first.c_str());
+                continue;
+            }
+            instancedDraw.attributes.emplace_back(shaderAttribute->second.position, attribute.second);
+        }
+        keepAlive(meshPtr, material_ptr);
+        RenderQueueObj rqObj{meshPtr.get(), glm::mat4(1), material_ptr.get()};
+        rqObj.instancedDraw = (int)instancedDraws.size();
+        instancedDraws.push_back(std::move(instancedDraw));
+        renderQueue.push_back(rqObj);
+    }
+
+    void RenderPass::drawRenderQueue() {
+        // find runs of draw calls sharing mesh, sub-mesh and material using an instanced shader
+        FrameArena* arena = &Renderer::instance->frameArena;
+        FrameVector<InstanceRun> instanceRuns(arena);
+        FrameVector<InstanceData> instanceData(arena);
+        FrameVector<DrawElementsIndirectCommand> commands(arena);
+        bool multiDraw = Renderer::instance->multiDrawIndirectSupported;
+        size_t i = 0;
+        while (i < renderQueue.size()){
+            auto& rqObj = renderQueue[i];
+            if (rqObj.instancedDraw != -1 || !rqObj.material->shader->isInstanced()){
+                i++;
+                continue;
+            }
+            size_t count = 1;
+            while (i + count < renderQueue.size()){
+                auto& next = renderQueue[i + count];
+                if (next.material != rqObj.material || next.instancedDraw != -1){
+                    break;
+                }
+                bool sameMesh = next.mesh == rqObj.mesh && next.subMesh == rqObj.subMesh;
+                // indexed meshes of the same geometry pool are combined using a multi draw call
+                bool samePool = multiDraw && rqObj.mesh->geometryPool != nullptr && next.mesh->geometryPool == rqObj.mesh->geometryPool &&
+                                !rqObj.mesh->elementBufferOffsetCount.empty() && !next.mesh->elementBufferOffsetCount.empty() &&
+                                next.mesh->getMeshTopology(next.subMesh) == rqObj.mesh->getMeshTopology(rqObj.subMesh);
+                if (!sameMesh && !samePool){
+                    break;
+                }
+                count++;
+            }
+            InstanceRun run{i, (int)count, instanceData.size()};
+            if (multiDraw && rqObj.mesh->geometryPool != nullptr){
+                // one command per sequence of draw calls using the same mesh (drawing them as instances)
+                run.firstCommand = commands.size();
+                size_t j = i;
+                while (j < i + count){
+                    size_t k = j + 1;
+                    while (k < i + count && renderQueue[k].mesh == renderQueue[j].mesh && renderQueue[k].subMesh == renderQueue[j].subMesh){
+                        k++;
+                    }
+                    Mesh* mesh = renderQueue[j].mesh;
+                    auto& offsetCount = mesh->elementBufferOffsetCount[renderQueue[j].subMesh];
+                    commands.push_back({offsetCount.size, (GLuint)(k - j), offsetCount.offset / (GLuint)sizeof(uint32_t), mesh->baseVertex, (GLuint)(j - i)});
+                    j = k;
+                }
+                run.commandCount = (int)(commands.size() - run.firstCommand);
+                if (run.commandCount == 1){
+                    commands.resize(run.firstCommand); // a single mesh uses an instanced draw call
+                    run.commandCount = 0;
+                }
+            }
+            instanceRuns.push_back(run);
+            for (size_t j = i; j < i + count; j++){
+                const glm::mat4& model = renderQueue[j].modelTransform;
+                const glm::mat3* modelInverseTranspose = normalMatrix(j);
+                if (modelInverseTranspose){
+                    instanceData.push_back({model, *modelInverseTranspose});
+                } else {
+                    instanceData.push_back({model, glm::transpose(glm::inverse((glm::mat3)model))});
+                }
+            }
+            i += count;
+        }
+
+        // layout of instance buffer: [instanceData][per drawInstanced(): transforms, attributes][normal matrices]
+        size_t bufferSize = sizeof(InstanceData) * instanceData.size();
+        FrameVector<glm::mat3> instanceNormalMatrices(arena);
+        for (auto& instancedDraw : instancedDraws){
+            instancedDraw.modelTransformsOffset = bufferSize;
+            bufferSize += sizeof(glm::mat4) * instancedDraw.count;
+            instancedDraw.attributesOffset.clear();
+            for (size_t j = 0; j < instancedDraw.attributes.size(); j++){
+                instancedDraw.attributesOffset.push_back(bufferSize);
+                bufferSize += sizeof(glm::vec4) * instancedDraw.count;
+            }
+        }
+        for (auto& rqObj : renderQueue){
+            if (rqObj.instancedDraw == -1 || rqObj.material->shader->attributeLocationInstanceModelInverseTranspose == -1){
+                continue;
+            }
+            auto& instancedDraw = instancedDraws[rqObj.instancedDraw];
+            instancedDraw.normalMatricesOffset = bufferSize + sizeof(glm::mat3) * instanceNormalMatrices.size();
+            size_t first = instanceNormalMatrices.size();
+            instanceNormalMatrices.resize(first + instancedDraw.count);
+            sre::computeNormalMatrices(instancedDraw.modelTransforms, sizeof(glm::mat4), instanceNormalMatrices.data() + first, instancedDraw.count);
+        }
+        bufferSize += sizeof(glm::mat3) * instanceNormalMatrices.size();
+
+        if (bufferSize > 0){
+            glBindBuffer(GL_ARRAY_BUFFER, Renderer::instance->instanceBuffer);
+            glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+            if (!instanceData.empty()){
+                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(InstanceData) * instanceData.size(), instanceData.data());
+            }
+            // the application data is streamed directly without an intermediate copy
+            for (auto& instancedDraw : instancedDraws){
+                glBufferSubData(GL_ARRAY_BUFFER, instancedDraw.modelTransformsOffset, sizeof(glm::mat4) * instancedDraw.count, instancedDraw.modelTransforms);
+                for (size_t j = 0; j < instancedDraw.attributes.size(); j++){
+                    glBufferSubData(GL_ARRAY_BUFFER, instancedDraw.attributesOffset[j], sizeof(glm::vec4) * instancedDraw.count, instancedDraw.attributes[j].second);
+                }
+            }
+            if (!instanceNormalMatrices.empty()){
+                glBufferSubData(GL_ARRAY_BUFFER, bufferSize - sizeof(glm::mat3) * instanceNormalMatrices.size(), sizeof(glm::mat3) * instanceNormalMatrices.size(), instanceNormalMatrices.data());
+            }
+        }
+
+#ifndef EMSCRIPTEN
+        if (!commands.empty()){
+            auto renderer = Renderer::instance;
+            if (renderer->indirectBuffer == 0){
+                glGenBuffers(1, &renderer->indirectBuffer);
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer->indirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * commands.size(), commands.data(), GL_STREAM_DRAW);
+        }
+#endif
+
+        writeDrawUniforms();
+        prepareOcclusionQueries();
+
+        auto drawQueue = [&](bool depthOnly){
+            auto run = instanceRuns.begin();
+            size_t index = 0;
+            while (index < renderQueue.size()){
+                bool draw = !depthOnly || isDepthPrepassed(index);
+                if (run != instanceRuns.end() && run->first == index){
+                    if (draw){
+                        drawInstance(index, run->count, run->firstInstance, depthOnly, run->commandCount, sizeof(DrawElementsIndirectCommand) * run->firstCommand);
+                    }
+                    index += run->count;
+                    ++run;
+                } else {
+                    if (draw && !depthOnly && !occlusionQueries.empty() && occlusionQueries[index].test != OcclusionTest::None){
+                        drawOcclusionQueried(index);
+                    } else if (draw){
+                        drawInstance(index, 0, 0, depthOnly);
+                    }
+                    index++;
+                }
+            }
+        };
+        if (builder.depthPrepass){
+            drawQueue(true);
+            lastBoundMaterial = nullptr;
+            lastBoundMesh = nullptr;
+        }
+        drawQueue(false);
+        if (builder.depthPrepass){
+            Renderer::instance->glState.depthFunc(GL_LESS);
+            lastBoundShader = nullptr; // restore the depth write state of the next shader
+        }
+    }
+
+    Shader* RenderPass::depthPrepassShader(const RenderQueueObj& rqObj) {
+        Shader* shader = rqObj.material->shader.get();
+        // only opaque draw calls writing depth (and color) are drawn in the pre-pass
+        if (!shader->depthTest || !shader->depthWrite || shader->blend != BlendType::Disabled ||
+            shader->stencil.func != StencilFunc::Disabled || !glm::any(shader->colorWrite)){
+            return nullptr;
+        }
+        // per-instance attributes are bound to locations of the shader (and may differ in the depth only variant)
+        if (rqObj.instancedDraw != -1 && !instancedDraws[rqObj.instancedDraw].attributes.empty()){
+            return nullptr;
+        }
+        return shader->getDepthOnlyShader();
+    }
+
+    bool RenderPass::isDepthPrepassed(size_t index) {
+        // bounding box queried draw calls are drawn (with depth writes) in the shading pass only, since the pre-pass
+        // would both draw occluded objects and hide their bounding boxes
+        if (!occlusionQueries.empty() && occlusionQueries[index].test == OcclusionTest::BoxQuery){
+            return false;
+        }
+        return depthPrepassShader(renderQueue[index]) != nullptr;
+    }
+
+    void RenderPass::prepareOcclusionQueries() {
+        occlusionQueries.clear();
+        auto renderer = Renderer::instance;
+        if (!builder.occlusionCulling || renderQueue.empty() || !renderer->initOcclusionQueries()){
+            return;
+        }
+        int frame = builder.renderStats->frame;
+        glm::vec4 frustumPlanes[6];
+        extractFrustumPlanes(projection * builder.camera.viewTransform, frustumPlanes);
+        const glm::vec4& nearPlane = frustumPlanes[4];
+        uint64_t passKey = std::hash<std::string>()(builder.name);
+        occlusionQueries.resize(renderQueue.size());
+        for (size_t i = 0; i < renderQueue.size(); i++){
+            auto& rqObj = renderQueue[i];
+            auto& occlusionQuery = occlusionQueries[i];
+            occlusionQuery = {0, OcclusionTest::None};
+            // only opaque (single instance) draw calls are queried (the skybox is never occluded)
+            Shader* shader = rqObj.material->shader.get();
+            if ((builder.skybox && i == 0) || rqObj.instancedDraw != -1 || shader->isInstanced() ||
+                    isTransparent(shader) || !shader->depthTest){
+                continue;
+            }
+            glm::vec3 worldCenter, worldExtent;
+            if (rqObj.precomputed){
+                if (!rqObj.precomputed->cullable){
+                    continue;
+                }
+                worldCenter = rqObj.precomputed->worldCenter;
+                worldExtent = rqObj.precomputed->worldExtent;
+            } else if (!computeWorldBounds(rqObj.mesh, rqObj.subMesh, rqObj.modelTransform, worldCenter, worldExtent)){
+                continue;
+            }
+            auto& entry = renderer->occlusionQueries[occlusionKey(passKey, rqObj.mesh->meshId, rqObj.material->materialId, rqObj.subMesh, worldCenter, worldExtent)];
+            if (entry.query != 0 && entry.lastFrame == frame){
+                continue; // the same draw call twice in a frame
+            }
+            entry.lastFrame = frame;
+            if (entry.query == 0){
+                entry.query = renderer->acquireQuery(renderer->occlusionQueryPool);
+            }
+            if (entry.pending){
+                // the result of the previous frame is read without stalling the pipeline
+                GLuint available = 0;
+                glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available){
+                    continue; // drawn (without a query) until the result is available
+                }
+                GLuint anySamplesPassed = 0;
+                glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT, &anySamplesPassed);
+                entry.occluded = anySamplesPassed == 0;
+                entry.pending = false;
+            }
+            // the bounding box cannot be queried when cut by the near plane
+            bool intersectsNearPlane = glm::dot(glm::vec3(nearPlane), worldCenter) + nearPlane.w <
+                                       glm::dot(glm::abs(glm::vec3(nearPlane)), worldExtent);
+            entry.pending = true;
+            occlusionQuery.query = entry.query;
+            if (entry.occluded && !intersectsNearPlane){
+                occlusionQuery.test = OcclusionTest::BoxQuery;
+                builder.renderStats->objectsOccluded++;
+            } else {
+                occlusionQuery.test = OcclusionTest::DrawQuery;
+                builder.renderStats->objectsVisible++;
+            }
+        }
+    }
+
+    void RenderPass::drawOcclusionQueried(size_t index) {
+        auto& occlusionQuery = occlusionQueries[index];
+        builder.renderStats->occlusionQueries++;
+        if (occlusionQuery.test == OcclusionTest::DrawQuery){
+            glBeginQuery(GL_ANY_SAMPLES_PASSED, occlusionQuery.query);
+            drawInstance(index);
+            glEndQuery(GL_ANY_SAMPLES_PASSED);
+            return;
+        }
+        drawOcclusionBox(index, occlusionQuery.query);
+#ifndef EMSCRIPTEN
+        if (Renderer::instance->conditionalRenderSupported){
+            // the GPU skips the draw call unless samples of the bounding box passed the depth test
+            glBeginConditionalRender(occlusionQuery.query, GL_QUERY_WAIT);
+            drawInstance(index);
+            glEndConditionalRender();
+        }
+#endif
+        // without conditional rendering (OpenGL ES / WebGL) the draw call is skipped until the query of the bounding box is visible
+    }
+
+    void RenderPass::drawOcclusionBox(size_t index, GLuint query) {
+        auto renderer = Renderer::instance;
+        RenderQueueObj& rqObj = renderQueue[index];
+        Shader* shader = renderer->occlusionBoxShader.get();
+        Mesh* mesh = renderer->occlusionBoxMesh.get();
+        builder.renderStats->drawCalls++;
+        if (lastBoundShader != shader){
+            builder.renderStats->stateChangesShader++;
+            lastBoundShader = shader;
+            shader->bind();
+            lastBoundMesh = nullptr; // vertex array objects are per shader
+        }
+        // the cube [-1;1] scaled to the mesh bounds (in model space)
+        auto bounds = rqObj.mesh->getBoundsMinMax();
+        glm::mat4 boxTransform = rqObj.modelTransform * glm::translate((bounds[0] + bounds[1]) * 0.5f) * glm::scale((bounds[1] - bounds[0]) * 0.5f);
+        glUniformMatrix4fv(renderer->occlusionBoxUniformLocation, 1, GL_FALSE, glm::value_ptr(boxTransform));
+        if (mesh != lastBoundMesh){
+            builder.renderStats->stateChangesMesh++;
+            lastBoundMesh = mesh;
+            mesh->bind(shader);
+        }
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+        drawMesh(mesh, 0, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    }
+
+    void RenderPass::writeDrawUniforms() {
+        drawSlots.clear();
+        drawUniformsOffset = 0;
+        drawUniformsRangeSize = 0;
+        boundDrawUniformsRange = -1;
+        auto renderer = Renderer::instance;
+        if (renderer->drawUniforms.getBuffer() == 0){
+            return;
+        }
+        // the draw uniforms are packed: only entries whose shader uses the block get a slot. A draw call binds the
+        // range of Shader::drawUniformBlockDraws slots containing its slot (once per range) and selects its slot using
+        // g_draw_index. The debug geometry uses the last entry (with an identity model transform)
+        bool debugSlot = hasDebugGeometry() && renderer->debugMaterial->shader->drawUniformBlock;
+        drawSlots.resize(renderQueue.size() + 1);
+        uint32_t count = 0;
+        for (size_t i = 0; i < renderQueue.size(); i++){
+            drawSlots[i] = renderQueue[i].material->shader->drawUniformBlock ? count++ : noDrawSlot;
+        }
+        drawSlots[renderQueue.size()] = debugSlot ? count++ : noDrawSlot;
+        if (count == 0){
+            drawSlots.clear();
+            return;
+        }
+        const size_t drawsPerRange = Shader::drawUniformBlockDraws;
+        size_t alignment = (size_t)renderer->uniformBufferOffsetAlignment;
+        size_t rangeSize = (sizeof(DrawUniforms) * drawsPerRange + alignment - 1) / alignment * alignment;
+        FrameVector<char> data(&renderer->frameArena);
+        data.resize(rangeSize * ((count + drawsPerRange - 1) / drawsPerRange));
+        auto slotData = [&](uint32_t slot){
+            return reinterpret_cast<DrawUniforms*>(data.data() + rangeSize * (slot / drawsPerRange) + sizeof(DrawUniforms) * (slot % drawsPerRange));
+        };
+        for (size_t i = 0; i < renderQueue.size(); i++){
+            if (drawSlots[i] == noDrawSlot){
+                continue;
+            }
+            const glm::mat3& modelInverseTranspose = *normalMatrix(i);
+            auto drawUniforms = slotData(drawSlots[i]);
+            drawUniforms->model = renderQueue[i].modelTransform;
+            writeMat3(drawUniforms->modelInverseTranspose, modelInverseTranspose);
+            // transpose(inverse(V*M)) = transpose(inverse(V)) * transpose(inverse(M))
+            writeMat3(drawUniforms->modelViewInverseTranspose, viewInverseTranspose * modelInverseTranspose);
+        }
+        if (debugSlot){
+            auto drawUniforms = slotData(drawSlots[renderQueue.size()]);
+            drawUniforms->model = glm::mat4(1);
+            writeMat3(drawUniforms->modelInverseTranspose, glm::mat3(1));
+            writeMat3(drawUniforms->modelViewInverseTranspose, viewInverseTranspose);
+        }
+        drawUniformsOffset = renderer->drawUniforms.write(data.data(), data.size(), builder.renderStats->frame);
+        drawUniformsRangeSize = rangeSize;
+    }
 
+    void RenderPass::computeNormalMatrices() {
+        // computed in a single batched pass (instead of per draw call while submitting to GL)
+        normalMatrices.clear();
+        bool required = false;
+        for (auto& rqObj : renderQueue){
+            if (rqObj.precomputed != nullptr){
+                continue;
+            }
+            Shader* shader = rqObj.material->shader.get();
+            if (shader->drawUniformBlock || shader->isInstanced() ||
+                shader->uniformLocationModelInverseTranspose != -1 || shader->uniformLocationModelViewInverseTranspose != -1){
+                required = true;
+                break;
+            }
+        }
+        if (!required){
+            return;
+        }
+        normalMatrices.resize(renderQueue.size());
+        sre::computeNormalMatrices(&renderQueue.data()->modelTransform, sizeof(RenderQueueObj), normalMatrices.data(), renderQueue.size());
+    }
+
+    const glm::mat3* RenderPass::normalMatrix(size_t index) {
+        if (renderQueue[index].precomputed){
+            return &renderQueue[index].precomputed->modelInverseTranspose;
+        }
+        if (index < normalMatrices.size()){
+            return &normalMatrices[index];
+        }
+        return nullptr;
+    }
+
+    void RenderPass::setInstanceAttributePointers(Shader* shader, size_t modelOffset, size_t modelStride, size_t normalMatrixOffset, size_t normalMatrixStride) {
+        // the attribute pointers are stored in the vertex array object of the mesh (for this shader)
+        glBindBuffer(GL_ARRAY_BUFFER, Renderer::instance->instanceBuffer);
+        for (int i=0;i<4;i++){
+            GLuint location = shader->attributeLocationInstanceModel + i;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, (GLsizei)modelStride, BUFFER_OFFSET(modelOffset + sizeof(glm::vec4)*i));
+            glVertexAttribDivisor(location, 1);
+        }
+        if (shader->attributeLocationInstanceModelInverseTranspose != -1){
+            for (int i=0;i<3;i++){
+                GLuint location = shader->attributeLocationInstanceModelInverseTranspose + i;
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, (GLsizei)normalMatrixStride, BUFFER_OFFSET(normalMatrixOffset + sizeof(glm::vec3)*i));
+                glVertexAttribDivisor(location, 1);
+            }
+        }
+    }
+
+    void RenderPass::drawMesh(Mesh* mesh, int subMesh, int instanceCount) {
+#ifndef EMSCRIPTEN
+        if (mesh->geometryPool != nullptr){
+            // the vertices of the mesh start at baseVertex in the buffer of the geometry pool
+            if (mesh->elementBufferOffsetCount.empty()){
+                if (instanceCount > 0){
+                    glDrawArraysInstanced((GLenum) mesh->getMeshTopology(), mesh->baseVertex, mesh->getVertexCount(), instanceCount);
+                } else {
+                    glDrawArrays((GLenum) mesh->getMeshTopology(), mesh->baseVertex, mesh->getVertexCount());
+                }
+            } else {
+                auto offsetCount = mesh->elementBufferOffsetCount[subMesh];
+                if (instanceCount > 0){
+                    glDrawElementsInstancedBaseVertex((GLenum) mesh->getMeshTopology(subMesh), offsetCount.size, offsetCount.type, BUFFER_OFFSET(offsetCount.offset), instanceCount, mesh->baseVertex);
+                } else {
+                    glDrawElementsBaseVertex((GLenum) mesh->getMeshTopology(subMesh), offsetCount.size, offsetCount.type, BUFFER_OFFSET(offsetCount.offset), mesh->baseVertex);
+                }
+            }
+            return;
+        }
+#endif
+        if (mesh->elementBufferOffsetCount.empty()){
+            if (instanceCount > 0){
+                glDrawArraysInstanced((GLenum) mesh->getMeshTopology(), 0, mesh->getVertexCount(), instanceCount);
+            } else {
+                glDrawArrays((GLenum) mesh->getMeshTopology(), 0, mesh->getVertexCount());
+            }
+        } else {
+            auto offsetCount = mesh->elementBufferOffsetCount[subMesh];
+            if (instanceCount > 0){
+                glDrawElementsInstanced((GLenum) mesh->getMeshTopology(subMesh), offsetCount.size, offsetCount.type, BUFFER_OFFSET(offsetCount.offset), instanceCount);
+            } else {
+                glDrawElements((GLenum) mesh->getMeshTopology(subMesh), offsetCount.size, offsetCount.type, BUFFER_OFFSET(offsetCount.offset));
+            }
+        }
+    }
 
-        Mesh* mesh = rqObj.mesh.get();
-        auto material = rqObj.material.get();
-        auto shader = material->getShader().get();
+    void RenderPass::drawInstance(size_t index, int instanceCount, size_t firstInstance, bool depthOnly, int drawCount, size_t indirectOffset) {
+        RenderQueueObj& rqObj = renderQueue[index];
+        Mesh* mesh = rqObj.mesh;
+        Material* material = rqObj.material;
+        Shader* shader = depthOnly ? depthPrepassShader(rqObj) : material->shader.get();
         LOG_ASSERT(mesh  != nullptr);
         builder.renderStats->drawCalls++;
-        setupShader(rqObj.modelTransform, shader);
-        if (material != lastBoundMaterial)
+        if (depthOnly && shader != lastBoundShader){
+            lastBoundMesh = nullptr; // vertex array objects are per shader
+        }
+        setupShader(rqObj.modelTransform, shader, normalMatrix(index), index);
+        if (builder.depthPrepass && !depthOnly){
+            // depth of draw calls in the pre-pass is already written
+            bool prepassed = isDepthPrepassed(index);
+            auto& glState = Renderer::instance->glState;
+            glState.depthFunc(prepassed ? GL_LEQUAL : GL_LESS);
+            glState.depthMask(prepassed ? false : shader->isDepthWrite());
+        }
+        if (depthOnly){
+            // the depth only fragment shader uses no material uniforms
+        } else if (material != lastBoundMaterial)
         {
             builder.renderStats->stateChangesMaterial++;
             lastBoundMaterial = material;
-            lastBoundMeshId = -1; // force mesh to rebind
+            lastBoundMesh = nullptr; // force mesh to rebind
             material->bind();
         }
-        if (mesh->meshId != lastBoundMeshId)
+        // meshes in a geometry pool share the vertex array object
+        const void* boundMesh = mesh->geometryPool ? (const void*)mesh->geometryPool : (const void*)mesh;
+        if (boundMesh != lastBoundMesh)
         {
             builder.renderStats->stateChangesMesh++;
-            lastBoundMeshId = mesh->meshId;
+            lastBoundMesh = boundMesh;
             mesh->bind(shader);
         }
-        if (mesh->elementBufferOffsetCount.empty()){
-            glDrawArrays((GLenum) mesh->getMeshTopology(), 0, mesh->getVertexCount());
+        if (rqObj.instancedDraw != -1){
+            auto& instancedDraw = instancedDraws[rqObj.instancedDraw];
+            setInstanceAttributePointers(shader, instancedDraw.modelTransformsOffset, sizeof(glm::mat4), instancedDraw.normalMatricesOffset, sizeof(glm::mat3));
+            for (size_t i = 0; i < instancedDraw.attributes.size(); i++){
+                GLuint location = instancedDraw.attributes[i].first;
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), BUFFER_OFFSET(instancedDraw.attributesOffset[i]));
+                glVertexAttribDivisor(location, 1);
+            }
+            drawMesh(mesh, rqObj.subMesh, (int)instancedDraw.count);
+            // restore the constant attributes of the mesh vertex array object
+            for (auto& attribute : instancedDraw.attributes){
+                glVertexAttribDivisor(attribute.first, 0);
+                glDisableVertexAttribArray(attribute.first);
+            }
+        } else if (shader->isInstanced()){
+            size_t offset = firstInstance * sizeof(InstanceData);
+            setInstanceAttributePointers(shader, offset + offsetof(InstanceData, model), sizeof(InstanceData), offset + offsetof(InstanceData, modelInverseTranspose), sizeof(InstanceData));
+#ifndef EMSCRIPTEN
+            if (drawCount > 0){
+                // the commands address the meshes in the geometry pool (and their instance data using base instance)
+                glMultiDrawElementsIndirect((GLenum) mesh->getMeshTopology(rqObj.subMesh), GL_UNSIGNED_INT, BUFFER_OFFSET(indirectOffset), drawCount, 0);
+                return;
+            }
+#endif
+            drawMesh(mesh, rqObj.subMesh, std::max(instanceCount, 1));
+        } else {
+            drawMesh(mesh, rqObj.subMesh, 0);
+        }
+    }
+
+    uint64_t RenderPass::computeSortKey(const RenderQueueObj& rqObj) {
+        // view depth of the center of the mesh bounds (or of the origin if the mesh has no bounds)
+        glm::vec3 worldCenter;
+        bool transparent;
+        uint64_t stateKey;
+        if (rqObj.precomputed){
+            worldCenter = rqObj.precomputed->worldCenter;
+            transparent = rqObj.precomputed->transparent;
+            stateKey = rqObj.precomputed->stateKey;
         } else {
-            auto offsetCount = mesh->elementBufferOffsetCount[rqObj.subMesh];
-            glDrawElements((GLenum) mesh->getMeshTopology(rqObj.subMesh), offsetCount.size, offsetCount.type, BUFFER_OFFSET(offsetCount.offset));
+            Shader* shader = rqObj.material->shader.get();
+            worldCenter = glm::vec3(rqObj.modelTransform * glm::vec4(boundsCenter(rqObj.mesh), 1.0f));
+            transparent = isTransparent(shader);
+            stateKey = computeStateKey(shader->shaderUniqueId, rqObj.material->materialId, rqObj.mesh->meshId);
+        }
+        glm::vec4 viewPos = builder.camera.viewTransform * glm::vec4(worldCenter, 1.0f);
+        uint64_t depth = quantizeDepth(-viewPos.z);
+
+        if (transparent){
+            return sortKeyBucketTransparent | ((sortKeyDepthMask - depth) << 44);
+        }
+        if (builder.sortMode == SortMode::FrontToBack){
+            return (depth << 44) | stateKey;
+        }
+        return (stateKey << 18) | depth;
+    }
+
+    void RenderPass::cullRenderQueue(size_t first) {
+        builder.renderStats->objectsSubmitted += (int)(renderQueue.size() - first);
+        if (!builder.frustumCulling || renderQueue.size() <= first){
+            builder.renderStats->objectsDrawn += (int)(renderQueue.size() - first);
+            return;
+        }
+        const size_t size = renderQueue.size() - first;
+        CullingData data(&Renderer::instance->frameArena);
+        data.resize(size);
+        for (size_t i = 0; i < size; i++){
+            auto& rqObj = renderQueue[i + first];
+            // instanced draw calls are never culled
+            glm::vec3 worldCenter{0.0f};
+            glm::vec3 worldExtent{0.0f};
+            bool cullable;
+            if (rqObj.precomputed){
+                cullable = rqObj.precomputed->cullable;
+                worldCenter = rqObj.precomputed->worldCenter;
+                worldExtent = rqObj.precomputed->worldExtent;
+            } else {
+                cullable = rqObj.instancedDraw == -1 &&
+                           computeWorldBounds(rqObj.mesh, rqObj.subMesh, rqObj.modelTransform, worldCenter, worldExtent);
+            }
+            data.cullable[i] = cullable;
+            data.centerX[i] = worldCenter.x; data.centerY[i] = worldCenter.y; data.centerZ[i] = worldCenter.z;
+            data.extentX[i] = worldExtent.x; data.extentY[i] = worldExtent.y; data.extentZ[i] = worldExtent.z;
+        }
+
+        glm::vec4 planes[6];
+        extractFrustumPlanes(projection * builder.camera.viewTransform, planes);
+        testFrustumPlanes(data, planes);
+
+        // remove culled objects (keeping the order of the remaining objects)
+        size_t dst = first;
+        for (size_t i = 0; i < size; i++){
+            if (data.outside[i] && data.cullable[i]){
+                continue;
+            }
+            if (dst != i + first){
+                renderQueue[dst] = std::move(renderQueue[i + first]);
+            }
+            dst++;
+        }
+        builder.renderStats->objectsCulled += (int)(renderQueue.size() - dst);
+        builder.renderStats->objectsDrawn += (int)(dst - first);
+        renderQueue.resize(dst);
+    }
+
+    void RenderPass::sortRenderQueue() {
+        // the skybox (if any) is always rendered first
+        size_t first = builder.skybox ? 1 : 0;
+        if (builder.sortMode == SortMode::None || renderQueue.size() <= first + 1){
+            return;
+        }
+        FrameArena* arena = &Renderer::instance->frameArena;
+        FrameVector<SortItem> items(arena);
+        FrameVector<SortItem> tmp(arena);
+        items.reserve(renderQueue.size() - first);
+        for (size_t i = first; i < renderQueue.size(); i++){
+            items.push_back({computeSortKey(renderQueue[i]), (uint32_t)i});
+        }
+        radixSort(items, tmp);
+
+        FrameVector<RenderQueueObj> sorted(arena);
+        sorted.reserve(renderQueue.size());
+        for (size_t i = 0; i < first; i++){
+            sorted.push_back(std::move(renderQueue[i]));
+        }
+        for (auto& item : items){
+            sorted.push_back(std::move(renderQueue[item.index]));
         }
+        renderQueue.swap(sorted);
     }
 
     void RenderPass::finishGPUCommandBuffer() {
@@ -439,7 +1654,8 @@ namespace sre {
         if (spriteBatch == nullptr) return;
 
         for (int i=0;i<spriteBatch->materials.size();i++) {
-            renderQueue.emplace_back(RenderQueueObj{spriteBatch->spriteMeshes[i], modelTransform, spriteBatch->materials[i]});
+            keepAlive(spriteBatch->spriteMeshes[i], spriteBatch->materials[i]);
+            renderQueue.push_back({spriteBatch->spriteMeshes[i].get(), modelTransform, spriteBatch->materials[i].get()});
         }
     }
 
@@ -448,7 +1664,8 @@ namespace sre {
         if (spriteBatch == nullptr) return;
 
         for (int i=0;i<spriteBatch->materials.size();i++) {
-            renderQueue.emplace_back(RenderQueueObj{spriteBatch->spriteMeshes[i], modelTransform, spriteBatch->materials[i]});
+            keepAlive(spriteBatch->spriteMeshes[i], spriteBatch->materials[i]);
+            renderQueue.push_back({spriteBatch->spriteMeshes[i].get(), modelTransform, spriteBatch->materials[i].get()});
         }
     }
 
@@ -22,8 +22,13 @@ __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 #include <sre/Renderer.hpp>
 #include <sre/Framebuffer.hpp>
 #include <sre/Texture.hpp>
+#include <sre/Shader.hpp>
+#include <sre/impl/GeometryPool.hpp>
 
 #include <sre/impl/GL.hpp>
+#include <algorithm>
+#include <limits>
+#include <cstring>
 #include <imgui_impl_opengl3.h>
 #include <imgui_impl_sdl2.h>
 
@@ -142,8 +147,23 @@ namespace sre {
             glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
         }
         renderInfo_.supportFBODepthAttachment = !renderInfo_.graphicsAPIVersionES || renderInfo_.graphicsAPIVersionMajor>2;
+        gpuTimersSupported = !renderInfo_.graphicsAPIVersionES && (
+                (renderInfo_.graphicsAPIVersionMajor == 3 && renderInfo_.graphicsAPIVersionMinor>=3) ||
+                (renderInfo_.graphicsAPIVersionMajor > 3));
+        if (gpuTimersSupported){
+            renderStats.gpuFrame = 0;
+        }
+        conditionalRenderSupported = !renderInfo_.graphicsAPIVersionES && renderInfo_.graphicsAPIVersionMajor >= 3;
+        geometryPoolSupported = !renderInfo_.graphicsAPIVersionES && (
+                (renderInfo_.graphicsAPIVersionMajor == 3 && renderInfo_.graphicsAPIVersionMinor>=2) ||
+                (renderInfo_.graphicsAPIVersionMajor > 3));
+        multiDrawIndirectSupported = !renderInfo_.graphicsAPIVersionES && (
+                (renderInfo_.graphicsAPIVersionMajor == 4 && renderInfo_.graphicsAPIVersionMinor>=3) ||
+                (renderInfo_.graphicsAPIVersionMajor > 4));
 
         initGlobalUniformBuffer();
+        initInstanceBuffer();
+        initDrawUniformBuffer();
 
         // initialize ImGUI (copied from ImGui SDL2 + OpenGL3 example)
         IMGUI_CHECKVERSION();
@@ -172,22 +192,68 @@ namespace sre {
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplSDL2_Shutdown();
         ImGui::DestroyContext();
-        glDeleteBuffers(1,&globalUniformBuffer);
+        globalUniforms.release();
+        glDeleteBuffers(1,&instanceBuffer);
+        drawUniforms.release();
+        glDeleteBuffers(1,&debugVertexBuffer);
+        if (debugVertexArray != 0){
+            glDeleteVertexArrays(1,&debugVertexArray);
+        }
+        debugMaterial.reset();
+        for (auto& entry : occlusionQueries){
+            occlusionQueryPool.push_back(entry.second.query);
+        }
+        if (!occlusionQueryPool.empty()){
+            glDeleteQueries((GLsizei)occlusionQueryPool.size(), occlusionQueryPool.data());
+        }
+        occlusionBoxShader.reset();
+        occlusionBoxMesh.reset();
+        for (auto& gpuTimer : gpuTimers){
+            timerQueryPool.push_back(gpuTimer.begin);
+            timerQueryPool.push_back(gpuTimer.end);
+        }
+        if (!timerQueryPool.empty()){
+            glDeleteQueries((GLsizei)timerQueryPool.size(), timerQueryPool.data());
+        }
+        geometryPools.clear();
+        transientFramebuffers.clear();
+        transientTextures.clear();
+        if (indirectBuffer != 0){
+            glDeleteBuffers(1,&indirectBuffer);
+        }
+        for (auto& pixelPackBuffer : pixelPackBuffers){
+            glDeleteBuffers(1,&pixelPackBuffer.buffer);
+        }
         SDL_GL_DeleteContext(glcontext);
         instance = nullptr;
     }
 
     void Renderer::swapWindow() {
+        readGpuTimers();
+        globalUniforms.fence(renderStats.frame);
+        drawUniforms.fence(renderStats.frame);
         renderStatsLast = renderStats;
         renderStats.frame++;
         renderStats.meshBytesAllocated=0;
         renderStats.meshBytesDeallocated=0;
+        renderStats.meshBytesUploaded=0;
         renderStats.textureBytesAllocated=0;
         renderStats.textureBytesDeallocated=0;
         renderStats.drawCalls=0;
         renderStats.stateChangesShader = 0;
         renderStats.stateChangesMesh = 0;
         renderStats.stateChangesMaterial = 0;
+        renderStats.objectsSubmitted = 0;
+        renderStats.objectsCulled = 0;
+        renderStats.objectsDrawn = 0;
+        renderStats.glCallsIssued = 0;
+        renderStats.glCallsSkipped = 0;
+        renderStats.occlusionQueries = 0;
+        renderStats.objectsOccluded = 0;
+        renderStats.objectsVisible = 0;
+        releaseUnusedOcclusionQueries();
+        releaseUnusedTransientTextures();
+        frameArena.reset();
 #ifndef EMSCRIPTEN
         SDL_GL_SwapWindow(window);
 #endif
@@ -226,14 +292,193 @@ namespace sre {
 
     void Renderer::initGlobalUniformBuffer(){
         if (renderInfo_.graphicsAPIVersionMajor <= 2){
-            globalUniformBuffer = 0;
-            return; //
+            return; // uniform buffers not supported
         }
-        glGenBuffers(1,&globalUniformBuffer);
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferOffsetAlignment);
         size_t lightSize = sizeof(glm::vec4)*(1 + maxSceneLights*2);
         globalUniformBufferSize = sizeof(glm::mat4)*2+sizeof(glm::vec4)*2 + lightSize;
-        glBindBuffer(GL_UNIFORM_BUFFER, globalUniformBuffer);
-        glBufferData(GL_UNIFORM_BUFFER, globalUniformBufferSize, NULL, GL_STREAM_DRAW);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        globalUniforms.init(64*1024, (size_t)uniformBufferOffsetAlignment);
+    }
+
+    void Renderer::initInstanceBuffer(){
+        if (renderInfo_.graphicsAPIVersionMajor <= 2){
+            instanceBuffer = 0;
+            return; // instancing not supported
+        }
+        glGenBuffers(1,&instanceBuffer);
+    }
+
+    void Renderer::initDrawUniformBuffer(){
+        if (renderInfo_.graphicsAPIVersionMajor <= 2){
+            return; // uniform buffers not supported
+        }
+        drawUniforms.init(1024*1024, (size_t)uniformBufferOffsetAlignment);
+    }
+
+    bool Renderer::initOcclusionQueries(){
+        if (occlusionBoxShader){
+            return true;
+        }
+        if (renderInfo_.graphicsAPIVersionMajor <= 2){
+            return false; // occlusion queries not supported
+        }
+        occlusionBoxShader = Shader::create()
+                .withSourceResource("occlusion_box_vert.glsl", ShaderType::Vertex)
+                .withSourceResource("depth_only_frag.glsl", ShaderType::Fragment)
+                .withName("Occlusion box")
+                .withDepthWrite(false)
+                .withColorWrite({false,false,false,false})
+                .withCullFace(CullFace::None)                 // the back faces are visible when the near plane cuts the box
+                .build();
+        if (!occlusionBoxShader){
+            return false;
+        }
+        occlusionBoxUniformLocation = occlusionBoxShader->getUniform("boxTransform").id;
+        occlusionBoxMesh = Mesh::create()
+                .withCube(1)
+                .withName("Occlusion box")
+                .build();
+        return true;
+    }
+
+    void Renderer::releaseUnusedTransientTextures(){
+        // kept for one unused frame (frame graphs executed every other frame still reuse their textures)
+        int frame = renderStats.frame;
+        for (auto it = transientFramebuffers.begin(); it != transientFramebuffers.end();){
+            if (it->second.lastFrame < frame - 1){
+                it = transientFramebuffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        transientTextures.erase(std::remove_if(transientTextures.begin(), transientTextures.end(), [&](const TransientTexture& t){
+            return t.lastFrame < frame - 1;
+        }), transientTextures.end());
+    }
+
+    GLuint Renderer::acquirePixelPackBuffer(size_t size){
+        // reuse the oldest released buffer large enough
+        for (auto it = pixelPackBuffers.begin(); it != pixelPackBuffers.end(); ++it){
+            if (it->size >= size){
+                GLuint buffer = it->buffer;
+                pixelPackBuffers.erase(it);
+                return buffer;
+            }
+        }
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return buffer;
+    }
+
+    void Renderer::releasePixelPackBuffer(GLuint buffer, size_t size){
+        const size_t maxPixelPackBuffers = 4;               // enough for continuous capture with 1-2 frames latency
+        pixelPackBuffers.push_back({buffer, size});
+        if (pixelPackBuffers.size() > maxPixelPackBuffers){
+            glDeleteBuffers(1, &pixelPackBuffers.front().buffer);
+            pixelPackBuffers.erase(pixelPackBuffers.begin());
+        }
+    }
+
+    GLuint Renderer::acquireQuery(std::vector<GLuint>& pool){
+        if (pool.empty()){
+            // query objects are created in batches and reused (no GL objects are created per frame)
+            pool.resize(64);
+            glGenQueries((GLsizei)pool.size(), pool.data());
+        }
+        GLuint query = pool.back();
+        pool.pop_back();
+        return query;
+    }
+
+    void Renderer::releaseUnusedOcclusionQueries(){
+        // draw calls not seen for two frames return their query object to the pool
+        // (called after the frame counter is incremented, so the last finished frame is frame - 1)
+        for (auto it = occlusionQueries.begin(); it != occlusionQueries.end();){
+            if (it->second.lastFrame < renderStats.frame - 2){
+                occlusionQueryPool.push_back(it->second.query);
+                it = occlusionQueries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void Renderer::beginGpuTimer(const std::string& name){
+        if (!gpuTimersSupported){
+            return;
+        }
+#ifndef EMSCRIPTEN
+        // timestamps (instead of GL_TIME_ELAPSED) allow timers to overlap other timer queries
+        GLuint begin = acquireQuery(timerQueryPool);
+        glQueryCounter(begin, GL_TIMESTAMP);
+        gpuTimers.push_back({name, renderStats.frame, begin, 0});
+#endif
+    }
+
+    void Renderer::endGpuTimer(){
+        if (!gpuTimersSupported){
+            return;
+        }
+#ifndef EMSCRIPTEN
+        LOG_ASSERT(!gpuTimers.empty() && gpuTimers.back().end == 0);
+        GLuint end = acquireQuery(timerQueryPool);
+        glQueryCounter(end, GL_TIMESTAMP);
+        gpuTimers.back().end = end;
+#endif
+    }
+
+    void Renderer::readGpuTimers(){
+#ifndef EMSCRIPTEN
+        // the timings of a frame are published when all timers of the frame are available (timers of later frames
+        // are not checked before that, since the GPU completes the frames in order)
+        size_t first = 0;
+        while (first < gpuTimers.size()){
+            int frame = gpuTimers[first].frame;
+            size_t last = first;
+            bool available = true;
+            while (available && last < gpuTimers.size() && gpuTimers[last].frame == frame){
+                GLuint beginAvailable = 0;
+                GLuint endAvailable = 0;
+                if (gpuTimers[last].end != 0){
+                    glGetQueryObjectuiv(gpuTimers[last].begin, GL_QUERY_RESULT_AVAILABLE, &beginAvailable);
+                    glGetQueryObjectuiv(gpuTimers[last].end, GL_QUERY_RESULT_AVAILABLE, &endAvailable);
+                }
+                available = beginAvailable && endAvailable;
+                last++;
+            }
+            if (!available){
+                break;
+            }
+            renderStats.gpuFrame = frame;
+            renderStats.gpuMilliseconds = 0;
+            renderStats.renderPassTimings.clear();
+            for (size_t i = first; i < last; i++){
+                GLuint64 begin = 0;
+                GLuint64 end = 0;
+                glGetQueryObjectui64v(gpuTimers[i].begin, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(gpuTimers[i].end, GL_QUERY_RESULT, &end);
+                float milliseconds = (float)((double)(end - begin) * 1e-6);
+                renderStats.gpuMilliseconds += milliseconds;
+                renderStats.renderPassTimings.push_back({gpuTimers[i].name, milliseconds});
+                timerQueryPool.push_back(gpuTimers[i].begin);
+                timerQueryPool.push_back(gpuTimers[i].end);
+            }
+            first = last;
+        }
+        gpuTimers.erase(gpuTimers.begin(), gpuTimers.begin() + first);
+#endif
+    }
+
+    GeometryPool* Renderer::getGeometryPool(const std::string& layout, int bytesPerVertex){
+        for (auto& pool : geometryPools){
+            if (pool->getLayout() == layout){
+                return pool.get();
+            }
+        }
+        geometryPools.emplace_back(new GeometryPool(layout, bytesPerVertex));
+        return geometryPools.back().get();
     }
 }
@@ -124,6 +124,7 @@ namespace sre{
     }
 
     SDLRenderer::~SDLRenderer() {
+        resolveCapturedImages(true);
         delete r;
         r = nullptr;
 
@@ -192,6 +193,7 @@ namespace sre{
                 recordFrame();
             }
             r->swapWindow();
+            resolveCapturedImages(false);
             frameNumber++;
         } else {
             deltaTimeUpdate = 0.0f;
@@ -836,6 +838,7 @@ namespace sre{
         frameRender();
         frameNumber++;
         r->swapWindow();
+        resolveCapturedImages(false);
     }
 
     int SDLRenderer::getFrameNumber() {
@@ -1887,17 +1890,35 @@ namespace sre{
     void SDLRenderer::captureFrameToFile(RenderPass * renderPass,
                                            std::filesystem::path path,
                                            bool captureFromScreen) {
-        std::cout << "Writing single image to filesystem..." << std::endl;
         glm::ivec2 dimensions = renderPass->frameSize();
-        writeImage(renderPass->readRawPixels(0, 0, dimensions.x,
-                   dimensions.y, captureFromScreen), dimensions, path);
+        m_pendingCaptures.push_back({renderPass->readRawPixelsAsync(0, 0, dimensions.x,
+                                     dimensions.y, captureFromScreen), -1, path});
     }
 
     void SDLRenderer::captureFrame(RenderPass * renderPass, bool captureFromScreen) {
         int i = m_image.size();
         m_imageDimensions.push_back(renderPass->frameSize());
-        m_image.push_back(renderPass->readRawPixels(0, 0, m_imageDimensions[i].x,
-                                       m_imageDimensions[i].y, captureFromScreen));
+        m_image.emplace_back();     // assigned when the readback has finished
+        m_pendingCaptures.push_back({renderPass->readRawPixelsAsync(0, 0, m_imageDimensions[i].x,
+                                     m_imageDimensions[i].y, captureFromScreen), i, {}});
+    }
+
+    void SDLRenderer::resolveCapturedImages(bool wait) {
+        // readbacks finish in the order they were issued
+        size_t resolved = 0;
+        for (auto& capture : m_pendingCaptures) {
+            if (!wait && !capture.readback->isReady()) {
+                break;
+            }
+            if (capture.imageIndex == -1) {
+                std::cout << "Writing single image to filesystem..." << std::endl;
+                writeImage(capture.readback->getRawPixels(), capture.readback->getSize(), capture.path);
+            } else {
+                m_image[capture.imageIndex] = capture.readback->getRawPixels();
+            }
+            resolved++;
+        }
+        m_pendingCaptures.erase(m_pendingCaptures.begin(), m_pendingCaptures.begin() + resolved);
     }
 
     int SDLRenderer::numCapturedImages() {
@@ -1909,6 +1930,7 @@ namespace sre{
             return;
         }
         m_writingImages = true;
+        resolveCapturedImages(true);
    
         LOG_ASSERT(m_image.size() == m_imageDimensions.size());
         if (m_image.size() > 0) {
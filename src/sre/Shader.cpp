@@ -249,6 +249,8 @@ namespace sre {
         shader->stencil = stencil;
         shader->colorWrite = colorWrite;
         shader->cullFace = cullFace;
+        shader->depthOnlyShader.reset();
+        shader->depthOnlyShaderCreated = false;
         return std::shared_ptr<Shader>(shader);
     }
 
@@ -364,11 +366,27 @@ namespace sre {
         uniformLocationLightPosType = -1;
         uniformLocationLightColorRange = -1;
         uniformLocationCameraPosition = -1;
+        uniformLocationDrawIndex = -1;
+        attributeLocationInstanceModel = -1;
+        attributeLocationInstanceModelInverseTranspose = -1;
         uniforms = std::make_shared<std::vector<Uniform>>();
+        materialUniformBlockSize = 0;
+        drawUniformBlock = false;
 
         bool hasGlobalUniformBuffer = false;
-        if (Renderer::instance->globalUniformBuffer) {
+        GLuint materialBlockIndex = GL_INVALID_INDEX;
+        if (Renderer::instance->globalUniforms.getBuffer()) {
             hasGlobalUniformBuffer = glGetUniformBlockIndex(shaderProgramId, "g_global_uniforms") != GL_INVALID_INDEX;
+            GLuint drawBlockIndex = glGetUniformBlockIndex(shaderProgramId, "g_draw_uniforms");
+            if (drawBlockIndex != GL_INVALID_INDEX){
+                glUniformBlockBinding(shaderProgramId, drawBlockIndex, drawUniformBindingIndex);
+                drawUniformBlock = true;
+            }
+            materialBlockIndex = glGetUniformBlockIndex(shaderProgramId, "material_uniforms");
+            if (materialBlockIndex != GL_INVALID_INDEX){
+                glUniformBlockBinding(shaderProgramId, materialBlockIndex, materialUniformBindingIndex);
+                glGetActiveUniformBlockiv(shaderProgramId, materialBlockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &materialUniformBlockSize);
+            }
         }
 
         GLint uniformCount;
@@ -436,9 +454,24 @@ namespace sre {
                 u.id = location;
                 u.arraySize = size;
                 u.type = uniformType;
+                if (materialBlockIndex != GL_INVALID_INDEX){
+                    GLuint index = (GLuint)i;
+                    GLint blockIndex;
+                    glGetActiveUniformsiv(shaderProgramId, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+                    if (blockIndex == (GLint)materialBlockIndex){
+                        glGetActiveUniformsiv(shaderProgramId, 1, &index, GL_UNIFORM_OFFSET, &u.blockOffset);
+                        glGetActiveUniformsiv(shaderProgramId, 1, &index, GL_UNIFORM_ARRAY_STRIDE, &u.arrayStride);
+                        glGetActiveUniformsiv(shaderProgramId, 1, &index, GL_UNIFORM_MATRIX_STRIDE, &u.matrixStride);
+                        u.id = -2 - i;  // block members have no location (ids below -1 are never sent using glUniform)
+                    }
+                }
                 uniforms->push_back(u);
             } else {
-                if (Renderer::instance->globalUniformBuffer){
+                if (strcmp(name, "g_draw_index")==0){
+                    uniformLocationDrawIndex = location;
+                    continue;
+                }
+                if (Renderer::instance->globalUniforms.getBuffer()){
                     if (strncmp(name, "g_model_it",64)!=0 &&
                         strncmp(name, "g_model_view_it",64)!=0 &&
                         strncmp(name, "g_model",64)!=0){
@@ -522,6 +555,19 @@ namespace sre {
             }
         }
 
+        // sampler uniforms use fixed texture units, so only the textures are bound when materials are bound
+        int textureUnit = 0;
+        for (auto& u : *uniforms){
+            if (u.type == UniformType::Texture || u.type == UniformType::TextureCube){
+                if (textureUnit == 0){
+                    Renderer::instance->glState.useProgram(shaderProgramId);
+                }
+                u.textureUnit = textureUnit;
+                glUniform1i(u.id, textureUnit);
+                textureUnit++;
+            }
+        }
+
         // update attributes
         attributes.clear();
         GLint attributeCount;
@@ -541,6 +587,23 @@ namespace sre {
                                    &type,
                                    name);
             auto location = glGetAttribLocation( shaderProgramId, name);
+            // per-instance attributes are set by the render pass (not by the mesh)
+            if (strcmp(name, "g_instance_model")==0){
+                if (type == GL_FLOAT_MAT4){
+                    attributeLocationInstanceModel = location;
+                } else {
+                    LOG_ERROR("Invalid g_instance_model attribute type. Expected mat4.");
+                }
+                continue;
+            }
+            if (strcmp(name, "g_instance_model_it")==0){
+                if (type == GL_FLOAT_MAT3){
+                    attributeLocationInstanceModelInverseTranspose = location;
+                } else {
+                    LOG_ERROR("Invalid g_instance_model_it attribute type. Expected mat3.");
+                }
+                continue;
+            }
             attributes[std::string(name)] = {location,type, size};
         }
     }
@@ -606,67 +669,54 @@ namespace sre {
     }
 
     void Shader::bind() {
-        glUseProgram(shaderProgramId);
-        if (depthTest) {
-            glEnable(GL_DEPTH_TEST);
-        } else {
-            glDisable(GL_DEPTH_TEST);
-        }
+        // only state differing from the current GL state results in GL calls
+        auto& glState = Renderer::instance->glState;
+        glState.useProgram(shaderProgramId);
+        glState.setEnabled(GLState::Capability::DepthTest, depthTest);
         if (stencil.func == StencilFunc::Disabled){
-            glDisable(GL_STENCIL_TEST);
-            glStencilMask(0);
+            glState.setEnabled(GLState::Capability::StencilTest, false);
+            glState.stencilMask(0);
         } else {
-            glEnable(GL_STENCIL_TEST);
-            glStencilFunc(static_cast<GLenum>(stencil.func), (GLint)stencil.ref, (GLint)stencil.mask);
-            glStencilOp(static_cast<GLenum>(stencil.fail),static_cast<GLenum>(stencil.zfail),static_cast<GLenum>(stencil.zpass));
-            glStencilMask(0xFFFF);
+            glState.setEnabled(GLState::Capability::StencilTest, true);
+            glState.stencilFunc(static_cast<GLenum>(stencil.func), (GLint)stencil.ref, (GLuint)stencil.mask);
+            glState.stencilOp(static_cast<GLenum>(stencil.fail),static_cast<GLenum>(stencil.zfail),static_cast<GLenum>(stencil.zpass));
+            glState.stencilMask(0xFFFF);
         }
         if (cullFace == CullFace::None){
-            glDisable(GL_CULL_FACE);
+            glState.setEnabled(GLState::Capability::CullFace, false);
         } else {
-            glEnable(GL_CULL_FACE);
+            glState.setEnabled(GLState::Capability::CullFace, true);
             if (cullFace == CullFace::Back){
-                glCullFace(GL_BACK);
+                glState.cullFace(GL_BACK);
             } else {
-                glCullFace(GL_FRONT);
+                glState.cullFace(GL_FRONT);
             }
         }
 
-        GLboolean dm = (GLboolean) (depthWrite ? GL_TRUE : GL_FALSE);
-        glDepthMask(dm);
-        glColorMask(colorWrite.r, colorWrite.g, colorWrite.b, colorWrite.a);
+        glState.depthMask(depthWrite);
+        glState.colorMask(colorWrite.r, colorWrite.g, colorWrite.b, colorWrite.a);
         switch (blend) {
             case BlendType::Disabled:
-                glDisable(GL_BLEND);
+                glState.setEnabled(GLState::Capability::Blend, false);
                 break;
             case BlendType::AlphaBlending:
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glState.setEnabled(GLState::Capability::Blend, true);
+                glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
                 break;
             case BlendType::AdditiveBlending:
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+                glState.setEnabled(GLState::Capability::Blend, true);
+                glState.blendFunc(GL_SRC_ALPHA, GL_ONE);
                 break;
             default:
                 LOG_ERROR("Invalid blend value - was %i",(int)blend);
                 break;
         }
-        auto& info = renderInfo();
-        if (offset.x == 0 && offset.y==0){
-            glDisable(GL_POLYGON_OFFSET_FILL);
-#ifndef GL_ES_VERSION_2_0
-            // GL_POLYGON_OFFSET_LINE and GL_POLYGON_OFFSET_POINT nor defined in ES 2.x or ES 3.x
-            glDisable(GL_POLYGON_OFFSET_LINE);
-            glDisable(GL_POLYGON_OFFSET_POINT);
-#endif
-        } else {
-            glEnable(GL_POLYGON_OFFSET_FILL);
-#ifndef GL_ES_VERSION_2_0
-            // GL_POLYGON_OFFSET_LINE and GL_POLYGON_OFFSET_POINT nor defined in ES 2.x or ES 3.x
-            glEnable(GL_POLYGON_OFFSET_LINE);
-            glEnable(GL_POLYGON_OFFSET_POINT);
-#endif
-            glPolygonOffset(offset.x, offset.y);
+        bool polygonOffset = offset.x != 0 || offset.y != 0;
+        glState.setEnabled(GLState::Capability::PolygonOffsetFill, polygonOffset);
+        glState.setEnabled(GLState::Capability::PolygonOffsetLine, polygonOffset);
+        glState.setEnabled(GLState::Capability::PolygonOffsetPoint, polygonOffset);
+        if (polygonOffset){
+            glState.polygonOffset(offset.x, offset.y);
         }
     }
 
@@ -849,7 +899,7 @@ namespace sre {
                 bool res = compileShader(shaderSourcesIter->second, shader, s, errors);
                 if (!res) {
                     cleanupShaders();
-                    glDeleteProgram( shaderProgramId );
+                    Renderer::instance->glState.deleteProgram( shaderProgramId );
                     shaderProgramId = oldShaderProgramId;
                     return false;
                 } else {
@@ -862,22 +912,20 @@ namespace sre {
         bool linked = linkProgram(shaderProgramId, errors);
         cleanupShaders();
         if (!linked) {
-            glDeleteProgram( shaderProgramId );
+            Renderer::instance->glState.deleteProgram( shaderProgramId );
             shaderProgramId = oldShaderProgramId; // revert to old shader
             return false;
         }
         if (oldShaderProgramId != 0){
-            glDeleteProgram( oldShaderProgramId ); // delete old shader if any
+            Renderer::instance->glState.deleteProgram( oldShaderProgramId ); // delete old shader if any
         }
         // setup global uniform
-        if (Renderer::instance->globalUniformBuffer){
-            glUseProgram(shaderProgramId);
+        if (Renderer::instance->globalUniforms.getBuffer()){
+            Renderer::instance->glState.useProgram(shaderProgramId);
             auto index = glGetUniformBlockIndex(shaderProgramId, "g_global_uniforms");
             if (index != GL_INVALID_INDEX){
-                const int globalUniformBindingIndex = 1;
+                // the range of the render pass is bound in RenderPass::setupGlobalShaderUniforms()
                 glUniformBlockBinding(shaderProgramId, index, globalUniformBindingIndex);
-                glBindBufferRange(GL_UNIFORM_BUFFER, globalUniformBindingIndex,
-                                  Renderer::instance->globalUniformBuffer, 0, Renderer::instance->globalUniformBufferSize);
             }
         }
 
@@ -962,6 +1010,40 @@ namespace sre {
         return std::shared_ptr<Material>(new Material(shared_from_this()));
     }
 
+    Shader* Shader::getDepthOnlyShader() {
+        if (depthOnlyShaderCreated){
+            return depthOnlyShader.get();
+        }
+        depthOnlyShaderCreated = true;
+        auto vertexSource = shaderSources.find(ShaderType::Vertex);
+        auto fragmentSource = shaderSources.find(ShaderType::Fragment);
+        if (vertexSource == shaderSources.end() || fragmentSource == shaderSources.end()){
+            return nullptr;
+        }
+        // fragments may be discarded or write their own depth (the depth would differ from the shaded depth)
+        std::vector<std::string> errors;
+        auto fragment = pragmaInclude(Resource::loadText(fragmentSource->second), errors, GL_FRAGMENT_SHADER);
+        if (fragment.find("discard") != std::string::npos || fragment.find("gl_FragDepth") != std::string::npos){
+            return nullptr;
+        }
+        auto res = Shader::ShaderBuilder();
+        res.depthTest = true;
+        res.depthWrite = true;
+        res.colorWrite = glm::bvec4(false, false, false, false);
+        res.blend = BlendType::Disabled;
+        res.name = name + " (depth only)";
+        res.offset = offset;
+        res.cullFace = cullFace;
+        res.shaderSources = shaderSources;   // geometry and tessellation stages (if any) are kept
+        res.shaderSources[ShaderType::Fragment] = "depth_only_frag.glsl";
+        res.specializationConstants = specializationConstants;
+        depthOnlyShader = res.build();
+        if (depthOnlyShader == nullptr){
+            LOG_WARNING("Cannot create depth only variant of shader %s", name.c_str());
+        }
+        return depthOnlyShader.get();
+    }
+
     const std::string& Shader::getName() {
         return name;
     }
@@ -1020,6 +1102,10 @@ namespace sre {
         return specializationConstants;
     }
 
+    bool Shader::isInstanced() {
+        return attributeLocationInstanceModel != -1;
+    }
+
     std::set<std::string> Shader::getAllSpecializationConstants() {
         if (parent){
             return parent->getAllSpecializationConstants();
@@ -1072,6 +1158,7 @@ namespace sre {
         stringstream ss;
 
         ss<<"#define SI_LIGHTS "<<Renderer::instance->maxSceneLights<<"\n";
+        ss<<"#define SI_DRAWS "<<drawUniformBlockDraws<<"\n";
         // add shader type
         switch (shaderType){
             case GL_FRAGMENT_SHADER:
@@ -38,6 +38,7 @@ namespace sre{
                                            .withUVs(uvs)
                                            .withIndices(indices)
                                            .withAttribute("vertex_color",colors)
+                                           .withUsage(MeshUsage::Stream)
                                            .build());
             auto mat = shader->createMaterial();
             mat->setTexture(lastTexture->shared_from_this());
@@ -87,7 +87,7 @@ namespace sre {
 
             r->textures.erase(std::remove(r->textures.begin(), r->textures.end(), this));
 
-            glDeleteTextures(1, &textureId);
+            r->glState.deleteTexture(textureId);
         }
 
     }
@@ -277,7 +277,7 @@ namespace sre {
                 }
                 GLint border = 0;
 
-                glBindTexture(target, textureId);
+                Renderer::instance->glState.bindTexture(0, target, textureId);
                 auto td = textureTypeData.find(GL_TEXTURE_2D);
                 textureDefPtr = &td->second;
                 glTexImage2D(target, 0, internalFormat, textureDefPtr->width,
@@ -305,7 +305,7 @@ namespace sre {
 
             GLint border = 0;
             GLenum type = GL_UNSIGNED_BYTE;
-            glBindTexture(target, textureId);
+            Renderer::instance->glState.bindTexture(0, target, textureId);
             void* dataPtr = textureDef.data.size()>0?textureDef.data.data(): nullptr;
             if (this->dumpDebug){
                 textureDef.dumpDebug();
@@ -336,7 +336,7 @@ namespace sre {
 
                     GLint border = 0;
                     GLenum type = GL_UNSIGNED_BYTE;
-                    glBindTexture(target, textureId);
+                    Renderer::instance->glState.bindTexture(0, target, textureId);
                     void* dataPtr = textureDef.data.size()>0?textureDef.data.data() : nullptr;
                     if (this->dumpDebug){
                         textureDef.dumpDebug();
@@ -412,7 +412,7 @@ namespace sre {
     Texture::TextureBuilder::~TextureBuilder() {
         if (Renderer::instance){
             if (textureId != 0){
-                glDeleteTextures(1, &textureId);
+                Renderer::instance->glState.deleteTexture(textureId);
             }
         }
     }
@@ -444,7 +444,7 @@ namespace sre {
     void Texture::updateTextureSampler(bool filterSampling, Wrap wrapTextureCoordinates) {
         this->filterSampling = filterSampling;
         this->wrapUV = wrapTextureCoordinates;
-        glBindTexture(target, textureId);
+        Renderer::instance->glState.bindTexture(0, target, textureId);
         auto wrapParam = wrapTextureCoordinates == Wrap::Repeat?GL_REPEAT:
                          (wrapTextureCoordinates == Wrap::Mirror ? GL_MIRRORED_REPEAT:
 #ifndef GL_ES_VERSION_2_0
@@ -664,7 +664,7 @@ namespace sre {
         std::vector<unsigned char> data(static_cast<unsigned long>(getWidth() * getHeight() * bytesPerPixel), 0);
         glPixelStorei(GL_UNPACK_ROW_LENGTH, getWidth());
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glBindTexture(GL_TEXTURE_2D, textureId);
+        Renderer::instance->glState.bindTexture(0, GL_TEXTURE_2D, textureId);
         glGetTexImage( GL_TEXTURE_2D, 0,  GL_RGBA, GL_UNSIGNED_BYTE, data.data());
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
         return data;
@@ -676,7 +676,7 @@ namespace sre {
     }
 
     void Texture::ReGenerateMipmaps() {
-        glBindTexture(target, textureId);
+        Renderer::instance->glState.bindTexture(0, target, textureId);
         invokeGenerateMipmap();
     }
 
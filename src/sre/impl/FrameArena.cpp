@@ -0,0 +1,62 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/FrameArena.hpp"
+#include <algorithm>
+
+namespace sre {
+
+    void* FrameArena::allocate(size_t size, size_t alignment) {
+        while (currentBlock < blocks.size()){
+            auto& block = blocks[currentBlock];
+            size_t offset = (currentOffset + alignment - 1) & ~(alignment - 1);
+            if (offset + size <= block.size){
+                currentOffset = offset + size;
+                bytesAllocated += size;
+                return block.data.get() + offset;
+            }
+            currentBlock++;
+            currentOffset = 0;
+        }
+        // allocate new block (new blocks are aligned to max_align_t)
+        size_t blockSize = std::max(std::max(minBlockSize, size + alignment), getCapacity());
+        blocks.push_back({std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+        currentBlock = blocks.size() - 1;
+        currentOffset = size;
+        bytesAllocated += size;
+        return blocks.back().data.get();
+    }
+
+    void FrameArena::reset() {
+        if (blocks.size() > 1){
+            // merge into one block fitting the previous frame
+            size_t capacity = getCapacity();
+            blocks.clear();
+            blocks.push_back({std::unique_ptr<char[]>(new char[capacity]), capacity});
+        }
+        currentBlock = 0;
+        currentOffset = 0;
+        bytesAllocated = 0;
+        generation++;
+    }
+
+    uint32_t FrameArena::getGeneration() {
+        return generation;
+    }
+
+    size_t FrameArena::getBytesAllocated() {
+        return bytesAllocated;
+    }
+
+    size_t FrameArena::getCapacity() {
+        size_t capacity = 0;
+        for (auto& block : blocks){
+            capacity += block.size;
+        }
+        return capacity;
+    }
+}
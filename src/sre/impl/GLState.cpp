@@ -0,0 +1,255 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/GLState.hpp"
+#include "sre/RenderStats.hpp"
+#include <limits>
+
+namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        constexpr GLuint unknownName = 0xFFFFFFFF;
+        constexpr GLenum unknownEnum = 0xFFFFFFFF;
+
+        GLenum toGLenum(GLState::Capability capability){
+            switch (capability){
+                case GLState::Capability::DepthTest:
+                    return GL_DEPTH_TEST;
+                case GLState::Capability::StencilTest:
+                    return GL_STENCIL_TEST;
+                case GLState::Capability::CullFace:
+                    return GL_CULL_FACE;
+                case GLState::Capability::Blend:
+                    return GL_BLEND;
+                case GLState::Capability::PolygonOffsetFill:
+                    return GL_POLYGON_OFFSET_FILL;
+#ifndef GL_ES_VERSION_2_0
+                // GL_POLYGON_OFFSET_LINE and GL_POLYGON_OFFSET_POINT nor defined in ES 2.x or ES 3.x
+                case GLState::Capability::PolygonOffsetLine:
+                    return GL_POLYGON_OFFSET_LINE;
+                case GLState::Capability::PolygonOffsetPoint:
+                    return GL_POLYGON_OFFSET_POINT;
+#endif
+                case GLState::Capability::ScissorTest:
+                    return GL_SCISSOR_TEST;
+                default:
+                    return 0;
+            }
+        }
+    }
+
+    GLState::GLState(RenderStats* renderStats)
+    :renderStats(renderStats)
+    {
+        reset();
+    }
+
+    void GLState::reset() {
+        program = unknownName;
+        framebuffer = unknownName;
+        textureUnit = unknownName;
+        for (int i=0;i<maxTrackedTextureUnits;i++){
+            textureTargets[i] = unknownEnum;
+            textures[i] = unknownName;
+        }
+        for (auto& capability : capabilities){
+            capability = -1;
+        }
+        colorWriteMask = -1;
+        depthWrite = -1;
+        depthFunction = unknownEnum;
+        stencilWriteMask = -1;
+        stencilFunction = unknownEnum;
+        stencilRef = -1;
+        stencilFuncMask = -1;
+        for (auto& op : stencilOperations){
+            op = unknownEnum;
+        }
+        blendSrc = unknownEnum;
+        blendDst = unknownEnum;
+        cullFaceMode = unknownEnum;
+        polygonOffsetFactor = std::numeric_limits<float>::quiet_NaN();
+        polygonOffsetUnits = std::numeric_limits<float>::quiet_NaN();
+        for (int i=0;i<4;i++){
+            viewportValue[i] = -1;
+            scissorValue[i] = -1;
+        }
+    }
+
+    bool GLState::changed(bool same) {
+        if (same){
+            renderStats->glCallsSkipped++;
+            return false;
+        }
+        renderStats->glCallsIssued++;
+        return true;
+    }
+
+    void GLState::useProgram(GLuint program) {
+        if (changed(this->program == program)){
+            this->program = program;
+            glUseProgram(program);
+        }
+    }
+
+    void GLState::bindFramebuffer(GLuint framebuffer) {
+        if (changed(this->framebuffer == framebuffer)){
+            this->framebuffer = framebuffer;
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+    }
+
+    void GLState::activeTexture(GLuint unit) {
+        if (changed(textureUnit == unit)){
+            textureUnit = unit;
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+    }
+
+    void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        bool tracked = unit < (GLuint)maxTrackedTextureUnits;
+        // a unit has a binding per target, but only the last bound target is known
+        if (changed(tracked && textureTargets[unit] == target && textures[unit] == texture)){
+            activeTexture(unit);
+            if (tracked){
+                textureTargets[unit] = target;
+                textures[unit] = texture;
+            }
+            glBindTexture(target, texture);
+        }
+    }
+
+    void GLState::setEnabled(Capability capability, bool enabled) {
+        GLenum cap = toGLenum(capability);
+        if (cap == 0){
+            return;
+        }
+        int8_t& value = capabilities[(int)capability];
+        if (changed(value == (int8_t)enabled)){
+            value = (int8_t)enabled;
+            if (enabled){
+                glEnable(cap);
+            } else {
+                glDisable(cap);
+            }
+        }
+    }
+
+    void GLState::depthMask(bool enabled) {
+        if (changed(depthWrite == (int8_t)enabled)){
+            depthWrite = (int8_t)enabled;
+            glDepthMask((GLboolean) (enabled ? GL_TRUE : GL_FALSE));
+        }
+    }
+
+    void GLState::depthFunc(GLenum func) {
+        if (changed(depthFunction == func)){
+            depthFunction = func;
+            glDepthFunc(func);
+        }
+    }
+
+    void GLState::colorMask(bool r, bool g, bool b, bool a) {
+        int8_t mask = (int8_t)((r ? 1 : 0) | (g ? 2 : 0) | (b ? 4 : 0) | (a ? 8 : 0));
+        if (changed(colorWriteMask == mask)){
+            colorWriteMask = mask;
+            glColorMask(r, g, b, a);
+        }
+    }
+
+    void GLState::stencilMask(GLuint mask) {
+        if (changed(stencilWriteMask == (int64_t)mask)){
+            stencilWriteMask = mask;
+            glStencilMask(mask);
+        }
+    }
+
+    void GLState::stencilFunc(GLenum func, GLint ref, GLuint mask) {
+        if (changed(stencilFunction == func && stencilRef == (int64_t)ref && stencilFuncMask == (int64_t)mask)){
+            stencilFunction = func;
+            stencilRef = ref;
+            stencilFuncMask = mask;
+            glStencilFunc(func, ref, mask);
+        }
+    }
+
+    void GLState::stencilOp(GLenum fail, GLenum zfail, GLenum zpass) {
+        if (changed(stencilOperations[0] == fail && stencilOperations[1] == zfail && stencilOperations[2] == zpass)){
+            stencilOperations[0] = fail;
+            stencilOperations[1] = zfail;
+            stencilOperations[2] = zpass;
+            glStencilOp(fail, zfail, zpass);
+        }
+    }
+
+    void GLState::blendFunc(GLenum src, GLenum dst) {
+        if (changed(blendSrc == src && blendDst == dst)){
+            blendSrc = src;
+            blendDst = dst;
+            glBlendFunc(src, dst);
+        }
+    }
+
+    void GLState::cullFace(GLenum mode) {
+        if (changed(cullFaceMode == mode)){
+            cullFaceMode = mode;
+            glCullFace(mode);
+        }
+    }
+
+    void GLState::polygonOffset(float factor, float units) {
+        if (changed(polygonOffsetFactor == factor && polygonOffsetUnits == units)){
+            polygonOffsetFactor = factor;
+            polygonOffsetUnits = units;
+            glPolygonOffset(factor, units);
+        }
+    }
+
+    void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (changed(viewportValue[0] == x && viewportValue[1] == y && viewportValue[2] == width && viewportValue[3] == height)){
+            viewportValue[0] = x;
+            viewportValue[1] = y;
+            viewportValue[2] = width;
+            viewportValue[3] = height;
+            glViewport(x, y, width, height);
+        }
+    }
+
+    void GLState::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (changed(scissorValue[0] == x && scissorValue[1] == y && scissorValue[2] == width && scissorValue[3] == height)){
+            scissorValue[0] = x;
+            scissorValue[1] = y;
+            scissorValue[2] = width;
+            scissorValue[3] = height;
+            glScissor(x, y, width, height);
+        }
+    }
+
+    void GLState::deleteProgram(GLuint program) {
+        if (this->program == program){
+            this->program = unknownName;
+        }
+        glDeleteProgram(program);
+    }
+
+    void GLState::deleteTexture(GLuint texture) {
+        for (int i=0;i<maxTrackedTextureUnits;i++){
+            if (textures[i] == texture){
+                textureTargets[i] = unknownEnum;
+                textures[i] = unknownName;
+            }
+        }
+        glDeleteTextures(1, &texture);
+    }
+
+    void GLState::deleteFramebuffer(GLuint framebuffer) {
+        if (this->framebuffer == framebuffer){
+            this->framebuffer = unknownName;
+        }
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/GeometryPool.hpp"
+#include "sre/Log.hpp"
+#include <algorithm>
+
+namespace sre {
+    GeometryPool::GeometryPool(std::string layout, int bytesPerVertex)
+    :layout(std::move(layout)), bytesPerVertex(bytesPerVertex)
+    {
+    }
+
+    GeometryPool::~GeometryPool() {
+        for (auto mesh : meshes){
+            mesh->geometryPool = nullptr;
+            mesh->vertexBufferId = 0;
+            mesh->elementBufferId = 0;
+        }
+        for (auto& arrayObj : shaderToVertexArrayObject){
+            glDeleteVertexArrays(1, &arrayObj.second.vaoID);
+        }
+        glDeleteBuffers(1, &vertexBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+    }
+
+    void GeometryPool::add(Mesh* mesh, const std::vector<float>& interleavedData) {
+        LOG_ASSERT(mesh->geometryPool == nullptr);
+        size_t vertexCount = (size_t)mesh->vertexCount;
+        size_t indexCount = 0;
+        for (auto& indexSet : mesh->indices){
+            indexCount += indexSet.size();
+        }
+        if (vertexCount > ranges.getVertices().getLargestFreeRange()){
+            grow(vertexBuffer, ranges.getVertices(), bytesPerVertex, std::max(vertexCount, minVertexCapacity));
+        }
+        if (indexCount > ranges.getIndices().getLargestFreeRange()){
+            grow(indexBuffer, ranges.getIndices(), sizeof(uint32_t), std::max(indexCount, minIndexCapacity));
+        }
+        GeometryPoolRanges::Range range;
+        if (!ranges.allocate(mesh, vertexCount, indexCount, range)){
+            LOG_ERROR("Mesh %s: cannot allocate %i vertices in the geometry pool", mesh->name.c_str(), (int)vertexCount);
+            return;
+        }
+        size_t firstVertex = range.firstVertex;
+        size_t firstIndex = range.firstIndex;
+        // uploaded using the copy target (binding GL_ELEMENT_ARRAY_BUFFER would modify the bound vertex array object)
+        if (vertexCount > 0){
+            glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * bytesPerVertex, vertexCount * bytesPerVertex, interleavedData.data());
+        }
+        mesh->elementBufferOffsetCount.clear();
+        if (indexCount > 0){
+            std::vector<uint32_t> concatenatedIndices;
+            concatenatedIndices.reserve(indexCount);
+            for (auto& indexSet : mesh->indices){
+                mesh->elementBufferOffsetCount.push_back({(uint32_t)((firstIndex + concatenatedIndices.size()) * sizeof(uint32_t)), (uint32_t)indexSet.size(), GL_UNSIGNED_INT});
+                concatenatedIndices.insert(concatenatedIndices.end(), indexSet.begin(), indexSet.end());
+            }
+            glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), concatenatedIndices.data());
+            mesh->dataSize += (int)(indexCount * sizeof(uint32_t));
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mesh->geometryPool = this;
+        mesh->baseVertex = (int)firstVertex;
+        mesh->vertexBufferId = vertexBuffer;
+        mesh->elementBufferId = indexBuffer;
+        meshes.push_back(mesh);
+    }
+
+    void GeometryPool::remove(Mesh* mesh) {
+        LOG_ASSERT(mesh->geometryPool == this);
+        // the recorded ranges are released (the vertex count of the mesh may already be updated)
+        ranges.free(mesh);
+        meshes.erase(std::remove(meshes.begin(), meshes.end(), mesh), meshes.end());
+        mesh->geometryPool = nullptr;
+        mesh->vertexBufferId = 0;
+        mesh->elementBufferId = 0;
+        mesh->elementBufferOffsetCount.clear();
+    }
+
+    void GeometryPool::grow(GLuint& buffer, RangeAllocator& allocator, size_t elementSize, size_t requiredSize) {
+        size_t oldCapacity = allocator.getCapacity();
+        size_t capacity = std::max(oldCapacity * 2, oldCapacity + requiredSize);
+        GLuint newBuffer;
+        glGenBuffers(1, &newBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity * elementSize, nullptr, GL_STATIC_DRAW);
+        if (buffer != 0){
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * elementSize);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer = newBuffer;
+        allocator.grow(capacity);
+
+        // the vertex array objects (and meshes) reference the old buffer
+        for (auto& arrayObj : shaderToVertexArrayObject){
+            glDeleteVertexArrays(1, &arrayObj.second.vaoID);
+        }
+        shaderToVertexArrayObject.clear();
+        for (auto mesh : meshes){
+            mesh->vertexBufferId = vertexBuffer;
+            mesh->elementBufferId = indexBuffer;
+        }
+    }
+
+    const std::string& GeometryPool::getLayout() {
+        return layout;
+    }
+
+    size_t GeometryPool::getVertexCapacity() {
+        return ranges.getVertices().getCapacity();
+    }
+
+    size_t GeometryPool::getIndexCapacity() {
+        return ranges.getIndices().getCapacity();
+    }
+}
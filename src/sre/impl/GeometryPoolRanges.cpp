@@ -0,0 +1,50 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/GeometryPoolRanges.hpp"
+#include "sre/Log.hpp"
+
+namespace sre {
+    bool GeometryPoolRanges::allocate(const void* owner, size_t vertexCount, size_t indexCount, Range& range) {
+        LOG_ASSERT(ranges.find(owner) == ranges.end() && "Ranges are already allocated");
+        size_t firstVertex = vertices.allocate(vertexCount);
+        if (firstVertex == RangeAllocator::invalid){
+            return false;
+        }
+        size_t firstIndex = indices.allocate(indexCount);
+        if (firstIndex == RangeAllocator::invalid){
+            vertices.free(firstVertex, vertexCount);
+            return false;
+        }
+        range = {firstVertex, vertexCount, firstIndex, indexCount};
+        ranges[owner] = range;
+        return true;
+    }
+
+    void GeometryPoolRanges::free(const void* owner) {
+        auto it = ranges.find(owner);
+        if (it == ranges.end()){
+            LOG_ERROR("GeometryPoolRanges::free() no ranges allocated");
+            return;
+        }
+        vertices.free(it->second.firstVertex, it->second.vertexCount);
+        indices.free(it->second.firstIndex, it->second.indexCount);
+        ranges.erase(it);
+    }
+
+    bool GeometryPoolRanges::contains(const void* owner) {
+        return ranges.find(owner) != ranges.end();
+    }
+
+    RangeAllocator& GeometryPoolRanges::getVertices() {
+        return vertices;
+    }
+
+    RangeAllocator& GeometryPoolRanges::getIndices() {
+        return indices;
+    }
+}
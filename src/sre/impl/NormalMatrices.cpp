@@ -0,0 +1,99 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/NormalMatrices.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        constexpr size_t batchSize = 64;
+        constexpr float uniformScaleEpsilon = 1e-5f;
+
+        // 3x3 matrices stored column-major as structure of arrays (m[column*3+row][matrix])
+        struct Batch {
+            float m[9][batchSize];
+            float n[9][batchSize];
+        };
+
+        // true if the columns are orthogonal and have the same (non-zero) length
+        bool isUniformScale(const Batch& b, size_t count){
+            int nonUniform = 0;
+            for (size_t i = 0; i < count; i++){
+                float aa = b.m[0][i]*b.m[0][i] + b.m[1][i]*b.m[1][i] + b.m[2][i]*b.m[2][i];
+                float bb = b.m[3][i]*b.m[3][i] + b.m[4][i]*b.m[4][i] + b.m[5][i]*b.m[5][i];
+                float cc = b.m[6][i]*b.m[6][i] + b.m[7][i]*b.m[7][i] + b.m[8][i]*b.m[8][i];
+                float ab = b.m[0][i]*b.m[3][i] + b.m[1][i]*b.m[4][i] + b.m[2][i]*b.m[5][i];
+                float bc = b.m[3][i]*b.m[6][i] + b.m[4][i]*b.m[7][i] + b.m[5][i]*b.m[8][i];
+                float ca = b.m[6][i]*b.m[0][i] + b.m[7][i]*b.m[1][i] + b.m[8][i]*b.m[2][i];
+                float eps = uniformScaleEpsilon * aa;
+                // bitwise or (instead of ||) keeps the loop free of branches
+                nonUniform |= (int)(aa <= 0.0f) |
+                        (int)(std::fabs(aa - bb) > eps) | (int)(std::fabs(aa - cc) > eps) |
+                        (int)(std::fabs(ab) > eps) | (int)(std::fabs(bc) > eps) | (int)(std::fabs(ca) > eps);
+            }
+            return nonUniform == 0;
+        }
+
+        // M = s*R gives transpose(inverse(M)) = R/s = M/s^2
+        void computeUniformScale(Batch& b, size_t count){
+            for (size_t i = 0; i < count; i++){
+                float invScaleSqr = 1.0f / (b.m[0][i]*b.m[0][i] + b.m[1][i]*b.m[1][i] + b.m[2][i]*b.m[2][i]);
+                for (int k = 0; k < 9; k++){
+                    b.n[k][i] = b.m[k][i] * invScaleSqr;
+                }
+            }
+        }
+
+        // for M = [a b c] transpose(inverse(M)) = [b x c, c x a, a x b] / det(M)
+        void computeGeneral(Batch& b, size_t count){
+            for (size_t i = 0; i < count; i++){
+                float a0 = b.m[0][i], a1 = b.m[1][i], a2 = b.m[2][i];
+                float b0 = b.m[3][i], b1 = b.m[4][i], b2 = b.m[5][i];
+                float c0 = b.m[6][i], c1 = b.m[7][i], c2 = b.m[8][i];
+                float bc0 = b1*c2 - b2*c1, bc1 = b2*c0 - b0*c2, bc2 = b0*c1 - b1*c0;
+                float ca0 = c1*a2 - c2*a1, ca1 = c2*a0 - c0*a2, ca2 = c0*a1 - c1*a0;
+                float ab0 = a1*b2 - a2*b1, ab1 = a2*b0 - a0*b2, ab2 = a0*b1 - a1*b0;
+                float det = a0*bc0 + a1*bc1 + a2*bc2;
+                // singular matrices give zero (using arithmetic instead of a branch)
+                float nonSingular = (float)(det != 0.0f);
+                float invDet = nonSingular / (det + (1.0f - nonSingular));
+                b.n[0][i] = bc0 * invDet; b.n[1][i] = bc1 * invDet; b.n[2][i] = bc2 * invDet;
+                b.n[3][i] = ca0 * invDet; b.n[4][i] = ca1 * invDet; b.n[5][i] = ca2 * invDet;
+                b.n[6][i] = ab0 * invDet; b.n[7][i] = ab1 * invDet; b.n[8][i] = ab2 * invDet;
+            }
+        }
+    }
+
+    void computeNormalMatrices(const glm::mat4* models, size_t modelStride, glm::mat3* normalMatrices, size_t count){
+        Batch batch;
+        auto bytes = reinterpret_cast<const char*>(models);
+        for (size_t first = 0; first < count; first += batchSize){
+            size_t size = std::min(batchSize, count - first);
+            for (size_t i = 0; i < size; i++){
+                auto model = reinterpret_cast<const float*>(bytes + (first + i) * modelStride);
+                for (int c = 0; c < 3; c++){
+                    for (int r = 0; r < 3; r++){
+                        batch.m[c*3+r][i] = model[c*4+r];
+                    }
+                }
+            }
+            if (isUniformScale(batch, size)){
+                computeUniformScale(batch, size);
+            } else {
+                computeGeneral(batch, size);
+            }
+            for (size_t i = 0; i < size; i++){
+                float* normalMatrix = &normalMatrices[first + i][0][0];
+                for (int k = 0; k < 9; k++){
+                    normalMatrix[k] = batch.n[k][i];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/RangeAllocator.hpp"
+#include "sre/Log.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace sre {
+    RangeAllocator::RangeAllocator(size_t capacity) {
+        grow(capacity);
+    }
+
+    size_t RangeAllocator::allocate(size_t size) {
+        if (size == 0){
+            return 0;
+        }
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it){
+            if (it->second < size){
+                continue;
+            }
+            size_t offset = it->first;
+            size_t remaining = it->second - size;
+            freeRanges.erase(it);
+            if (remaining > 0){
+                freeRanges[offset + size] = remaining;
+            }
+            return offset;
+        }
+        return invalid;
+    }
+
+    void RangeAllocator::free(size_t offset, size_t size) {
+        if (size == 0){
+            return;
+        }
+        LOG_ASSERT(offset + size <= capacity);
+        auto next = freeRanges.lower_bound(offset);
+        LOG_ASSERT((next == freeRanges.end() || offset + size <= next->first) && "Range is already free");
+        // merge with the following range
+        if (next != freeRanges.end() && next->first == offset + size){
+            size += next->second;
+            next = freeRanges.erase(next);
+        }
+        // merge with the preceding range
+        if (next != freeRanges.begin()){
+            auto prev = std::prev(next);
+            LOG_ASSERT(prev->first + prev->second <= offset && "Range is already free");
+            if (prev->first + prev->second == offset){
+                prev->second += size;
+                return;
+            }
+        }
+        freeRanges.emplace_hint(next, offset, size);
+    }
+
+    void RangeAllocator::grow(size_t newCapacity) {
+        if (newCapacity <= capacity){
+            return;
+        }
+        size_t oldCapacity = capacity;
+        capacity = newCapacity;
+        free(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    size_t RangeAllocator::getCapacity() {
+        return capacity;
+    }
+
+    size_t RangeAllocator::getFreeSize() {
+        size_t size = 0;
+        for (auto& range : freeRanges){
+            size += range.second;
+        }
+        return size;
+    }
+
+    size_t RangeAllocator::getLargestFreeRange() {
+        size_t size = 0;
+        for (auto& range : freeRanges){
+            size = std::max(size, range.second);
+        }
+        return size;
+    }
+}
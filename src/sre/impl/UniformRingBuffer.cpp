@@ -0,0 +1,87 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/UniformRingBuffer.hpp"
+#include <cstring>
+
+namespace sre {
+    void UniformRingBuffer::init(size_t segmentSize, size_t alignment) {
+        this->segmentSize = segmentSize;
+        this->alignment = alignment;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, segmentSize * segments, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void UniformRingBuffer::release() {
+        if (buffer != 0){
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+        for (auto& fence : fences){
+            if (fence != nullptr){
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+    }
+
+    size_t UniformRingBuffer::write(const void* data, size_t size, int frame) {
+        int segment = frame % segments;
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (segmentOffset + size > segmentSize){
+            // more data than fits in a segment: grow the ring (the driver keeps the old storage until draws using it
+            // are done, so the fences are no longer needed)
+            do {
+                segmentSize *= 2;
+            } while (size > segmentSize);
+            glBufferData(GL_UNIFORM_BUFFER, segmentSize * segments, NULL, GL_STREAM_DRAW);
+            for (auto& fence : fences){
+                if (fence != nullptr){
+                    glDeleteSync(fence);
+                    fence = nullptr;
+                }
+            }
+            segmentOffset = 0;
+        }
+        if (fences[segment] != nullptr){
+            // wait until the GPU has finished the frame that last used the segment (normally done long ago)
+            glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fences[segment]);
+            fences[segment] = nullptr;
+        }
+        size_t offset = segment * segmentSize + segmentOffset;
+#ifdef EMSCRIPTEN
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+#else
+        // the range is not used by the GPU (guarded by the fence): write without synchronization or orphaning
+        void* dst = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (dst != nullptr){
+            memcpy(dst, data, size);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        } else {
+            glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        }
+#endif
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        segmentOffset += (size + alignment - 1) / alignment * alignment;
+        return offset;
+    }
+
+    void UniformRingBuffer::fence(int frame) {
+        if (segmentOffset == 0){
+            return; // segment not used this frame
+        }
+        fences[frame % segments] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        segmentOffset = 0;
+    }
+
+    GLuint UniformRingBuffer::getBuffer() {
+        return buffer;
+    }
+}
@@ -6,35 +6,39 @@
  */
 #include <glm/gtc/type_ptr.hpp>
 #include "sre/impl/UniformSet.hpp"
+#include "sre/Renderer.hpp"
 
 namespace sre {
 
     void UniformSet::bind(){
-        unsigned int textureSlot = 0;
+        // the sampler uniforms are assigned to texture units when the shader is linked
+        auto& glState = Renderer::instance->glState;
         for (const auto & t : textureValues) {
-
-            glActiveTexture(GL_TEXTURE0 + textureSlot);
-            glBindTexture(t.second->target, t.second->textureId);
-            glUniform1i(t.first, textureSlot);
-            textureSlot++;
+            if (t.second.unit != -1 && t.second.texture) {
+                glState.bindTexture((GLuint)t.second.unit, t.second.texture->target, t.second.texture->textureId);
+            }
         }
+        // uniforms in the material uniform block have negative ids (written by Material)
         for (auto& t : vectorValues) {
+            if (t.first < 0) continue;
             glUniform4fv(t.first, 1, glm::value_ptr(t.second));
         }
         for (auto& t : mat4Values) {
+            if (t.first < 0) continue;
             glUniformMatrix4fv(t.first, 1, GL_FALSE, glm::value_ptr(t.second));
         }
         for (auto& t : floatValues) {
+            if (t.first < 0) continue;
             glUniform1f(t.first, t.second);
         }
         for (auto& t : mat3sValues) {
-            if (t.second.get()) {
+            if (t.first >= 0 && t.second.get()) {
                 glm::mat3& m3 = (*t.second)[0];
                 glUniformMatrix3fv(t.first, static_cast<GLsizei>(t.second->size()), GL_FALSE, glm::value_ptr(m3));
             }
         }
         for (auto& t : mat4sValues) {
-            if (t.second.get()){
+            if (t.first >= 0 && t.second.get()){
                 glm::mat4& m4 = (*t.second)[0];
                 glUniformMatrix4fv(t.first, static_cast<GLsizei>(t.second->size()), GL_FALSE, glm::value_ptr(m4));
             }
@@ -55,7 +59,11 @@ namespace sre {
     }
 
     void UniformSet::set(int id, std::shared_ptr<Texture> value){
-        textureValues[id] = value;
+        textureValues[id].texture = value;
+    }
+
+    void UniformSet::setTextureUnit(int id, int unit){
+        textureValues[id].unit = unit;
     }
 
     void UniformSet::set(int id, std::shared_ptr<std::vector<glm::mat3>> value){
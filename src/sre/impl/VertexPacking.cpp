@@ -0,0 +1,147 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/VertexPacking.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        template<typename T>
+        T toUNorm(float value, float max){
+            return (T)std::lround(std::min(std::max(value, 0.0f), 1.0f) * max);
+        }
+
+        template<typename T>
+        T toSNorm(float value, float max){
+            return (T)std::lround(std::min(std::max(value, -1.0f), 1.0f) * max);
+        }
+
+        template<typename T>
+        void write(void* dest, int index, T value){
+            memcpy(static_cast<char*>(dest) + index * sizeof(T), &value, sizeof(T));
+        }
+
+        // x in bit 0-9, y in bit 10-19, z in bit 20-29 and w in bit 30-31
+        uint32_t pack10_10_10_2(const float* values, int components, bool isSigned){
+            uint32_t res = 0;
+            for (int i = 0; i < 4; i++){
+                int bits = i < 3 ? 10 : 2;
+                float value = i < components ? values[i] : 0.0f;
+                uint32_t mask = (1u << bits) - 1;
+                int32_t q;
+                if (isSigned){
+                    q = toSNorm<int32_t>(value, (float)((1 << (bits - 1)) - 1));
+                } else {
+                    q = toUNorm<int32_t>(value, (float)mask);
+                }
+                res |= ((uint32_t)q & mask) << (i * 10);
+            }
+            return res;
+        }
+    }
+
+    uint16_t floatToHalf(float value){
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(float));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t floatExponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+        if (floatExponent == 0xff){
+            return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));    // infinity or NaN
+        }
+        int32_t exponent = (int32_t)floatExponent - 127 + 15;
+        if (exponent >= 31){
+            return (uint16_t)(sign | 0x7c00);                             // overflow gives infinity
+        }
+        if (exponent <= 0){
+            // subnormal half (or zero)
+            if (exponent < -10){
+                return (uint16_t)sign;
+            }
+            mantissa |= 0x800000;
+            uint32_t shift = (uint32_t)(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1))){
+                half++;
+            }
+            return (uint16_t)(sign | half);
+        }
+        uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))){
+            half++;                                                         // may carry into the exponent (rounding up to infinity)
+        }
+        return (uint16_t)(sign | half);
+    }
+
+    int vertexAttributeBytes(VertexAttributeFormat format, int components){
+        int bytes;
+        switch (format){
+            case VertexAttributeFormat::Half:
+            case VertexAttributeFormat::UNorm16:
+            case VertexAttributeFormat::SNorm16:
+                bytes = 2 * components;
+                break;
+            case VertexAttributeFormat::UNorm8:
+            case VertexAttributeFormat::SNorm8:
+                bytes = components;
+                break;
+            case VertexAttributeFormat::UNorm10_10_10_2:
+            case VertexAttributeFormat::SNorm10_10_10_2:
+                bytes = 4;
+                break;
+            default:
+                bytes = 4 * components;
+                break;
+        }
+        return (bytes + 3) / 4 * 4;
+    }
+
+    void packVertexAttribute(VertexAttributeFormat format, const float* values, int components, void* dest){
+        switch (format){
+            case VertexAttributeFormat::Half:
+                for (int i = 0; i < components; i++){
+                    write(dest, i, floatToHalf(values[i]));
+                }
+                break;
+            case VertexAttributeFormat::UNorm8:
+                for (int i = 0; i < components; i++){
+                    write(dest, i, toUNorm<uint8_t>(values[i], 255.0f));
+                }
+                break;
+            case VertexAttributeFormat::SNorm8:
+                for (int i = 0; i < components; i++){
+                    write(dest, i, toSNorm<int8_t>(values[i], 127.0f));
+                }
+                break;
+            case VertexAttributeFormat::UNorm16:
+                for (int i = 0; i < components; i++){
+                    write(dest, i, toUNorm<uint16_t>(values[i], 65535.0f));
+                }
+                break;
+            case VertexAttributeFormat::SNorm16:
+                for (int i = 0; i < components; i++){
+                    write(dest, i, toSNorm<int16_t>(values[i], 32767.0f));
+                }
+                break;
+            case VertexAttributeFormat::UNorm10_10_10_2:
+                write(dest, 0, pack10_10_10_2(values, components, false));
+                break;
+            case VertexAttributeFormat::SNorm10_10_10_2:
+                write(dest, 0, pack10_10_10_2(values, components, true));
+                break;
+            default:
+                memcpy(dest, values, sizeof(float) * components);
+                break;
+        }
+    }
+}
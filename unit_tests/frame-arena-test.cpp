@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include "sre/impl/FrameArena.hpp"
+
+using namespace sre;
+
+TEST(FrameArena, AllocationsAreAligned)
+{
+    FrameArena arena;
+    for (size_t alignment : {1, 4, 8, 16}){
+        arena.allocate(3, 1);
+        void* p = arena.allocate(24, alignment);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignment);
+    }
+}
+
+TEST(FrameArena, ResetReusesMemory)
+{
+    FrameArena arena;
+    void* first = arena.allocate(1000, 16);
+    arena.allocate(200000, 16);             // larger than one block
+    arena.reset();
+    size_t capacity = arena.getCapacity();
+    EXPECT_EQ(0u, arena.getBytesAllocated());
+
+    // steady state: same workload does not grow the arena
+    for (int frame = 0; frame < 3; frame++){
+        arena.allocate(1000, 16);
+        arena.allocate(200000, 16);
+        arena.reset();
+        EXPECT_EQ(capacity, arena.getCapacity());
+    }
+    (void)first;
+}
+
+TEST(FrameVector, PushBackAndGrow)
+{
+    FrameArena arena;
+    FrameVector<int> vector(&arena);
+    for (int i = 0; i < 1000; i++){
+        vector.push_back(i);
+    }
+    ASSERT_EQ(1000u, vector.size());
+    for (int i = 0; i < 1000; i++){
+        EXPECT_EQ(i, vector[i]);
+    }
+    vector.resize(10);
+    EXPECT_EQ(10u, vector.size());
+    EXPECT_EQ(9, vector.back());
+}
+
+TEST(FrameVector, CopyOutlivesFrame)
+{
+    FrameArena arena;
+    auto value = std::make_shared<int>(42);
+    FrameVector<std::shared_ptr<int>> copy;
+    {
+        FrameVector<std::shared_ptr<int>> vector(&arena);
+        vector.push_back(value);
+        vector.push_back(value);
+        EXPECT_EQ(3, value.use_count());
+        copy = vector;
+    }
+    arena.reset();
+    ASSERT_EQ(2u, copy.size());
+    EXPECT_EQ(42, *copy[1]);
+    EXPECT_EQ(3, value.use_count());
+    copy.clear();
+    EXPECT_EQ(1, value.use_count());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
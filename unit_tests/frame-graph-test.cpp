@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "sre/FrameGraph.hpp"
+
+using namespace sre;
+
+namespace {
+    using Pass = FrameGraph::PassBuilder;
+    using Names = std::vector<std::string>;
+
+    FrameGraph::TextureDescription color(){
+        FrameGraph::TextureDescription description;
+        description.size = {64, 64};
+        return description;
+    }
+
+    void noop(FrameGraph::PassContext&){
+    }
+}
+
+TEST(FrameGraph, ReadersRunAfterAllWriters)
+{
+    FrameGraph graph;
+    FrameGraph::Resource scene = -1;
+    graph.addPass("Opaque", [&](Pass& pass){ scene = pass.createTexture("Scene", color()); }, noop);
+    graph.addPass("Composite", [&](Pass& pass){ pass.read(scene); pass.writeScreen(); }, noop);
+    graph.addPass("Transparent", [&](Pass& pass){ pass.write(scene); }, noop);
+    EXPECT_EQ((Names{"Opaque", "Transparent", "Composite"}), graph.getPassOrder());
+}
+
+TEST(FrameGraph, UnreadOutputsAreCulled)
+{
+    FrameGraph graph;
+    FrameGraph::Resource used = -1;
+    graph.addPass("Unused", [&](Pass& pass){ pass.createTexture("Unused", color()); }, noop);
+    graph.addPass("Used", [&](Pass& pass){ used = pass.createTexture("Used", color()); }, noop);
+    graph.addPass("ReadsUnused", [&](Pass& pass){ pass.read(used); pass.createTexture("Dead end", color()); }, noop);
+    graph.addPass("Final", [&](Pass& pass){ pass.read(used); pass.writeScreen(); }, noop);
+    EXPECT_EQ((Names{"Used", "Final"}), graph.getPassOrder());
+}
+
+TEST(FrameGraph, IndependentPassesKeepDeclarationOrder)
+{
+    FrameGraph graph;
+    FrameGraph::Resource a = -1;
+    FrameGraph::Resource b = -1;
+    FrameGraph::Resource c = -1;
+    graph.addPass("C", [&](Pass& pass){ c = pass.createTexture("C", color()); }, noop);
+    graph.addPass("A", [&](Pass& pass){ a = pass.createTexture("A", color()); }, noop);
+    graph.addPass("B", [&](Pass& pass){ b = pass.createTexture("B", color()); }, noop);
+    graph.addPass("Final", [&](Pass& pass){ pass.read(b); pass.read(a); pass.read(c); pass.writeScreen(); }, noop);
+    Names expected{"C", "A", "B", "Final"};
+    EXPECT_EQ(expected, graph.getPassOrder());
+    EXPECT_EQ(expected, graph.getPassOrder());  // repeated compiles give the same order
+}
+
+TEST(FrameGraph, WritersOfATextureRunInDeclarationOrder)
+{
+    FrameGraph graph;
+    FrameGraph::Resource target = -1;
+    graph.addPass("Clear", [&](Pass& pass){ target = pass.createTexture("Target", color()); }, noop);
+    graph.addPass("Opaque", [&](Pass& pass){ pass.write(target); }, noop);
+    graph.addPass("Transparent", [&](Pass& pass){ pass.write(target); }, noop);
+    graph.addPass("Final", [&](Pass& pass){ pass.read(target); pass.writeScreen(); }, noop);
+    EXPECT_EQ((Names{"Clear", "Opaque", "Transparent", "Final"}), graph.getPassOrder());
+}
+
+TEST(FrameGraph, CycleFallsBackToDeclarationOrder)
+{
+    FrameGraph graph;
+    FrameGraph::Resource first = -1;
+    FrameGraph::Resource second = -1;
+    graph.addPass("First", [&](Pass& pass){ first = pass.createTexture("First", color()); }, noop);
+    graph.addPass("Second", [&](Pass& pass){ pass.read(first); second = pass.createTexture("Second", color()); }, noop);
+    graph.addPass("Feedback", [&](Pass& pass){ pass.read(second); pass.write(first); pass.writeScreen(); }, noop);
+    // Second reads First (written by Feedback) and Feedback reads Second
+    EXPECT_EQ((Names{"First", "Second", "Feedback"}), graph.getPassOrder());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "sre/impl/GeometryPoolRanges.hpp"
+
+using namespace sre;
+
+namespace {
+    // Mesh::update() of a pooled mesh: the mesh is removed from the pool and added with the new vertex count
+    GeometryPoolRanges::Range update(GeometryPoolRanges& ranges, const void* mesh, size_t vertexCount, size_t indexCount){
+        ranges.free(mesh);
+        GeometryPoolRanges::Range range;
+        EXPECT_TRUE(ranges.allocate(mesh, vertexCount, indexCount, range));
+        return range;
+    }
+}
+
+TEST(GeometryPoolRanges, UpdateToLargerVertexCount)
+{
+    GeometryPoolRanges ranges;
+    ranges.getVertices().grow(1000);
+    ranges.getIndices().grow(1000);
+    int meshA, meshB;
+    GeometryPoolRanges::Range a, b;
+    ASSERT_TRUE(ranges.allocate(&meshA, 100, 200, a));
+    ASSERT_TRUE(ranges.allocate(&meshB, 100, 200, b));
+    EXPECT_EQ(100u, b.firstVertex);
+
+    a = update(ranges, &meshA, 150, 300);
+    // the old range of A is too small, so A moves after B (B keeps its vertices)
+    EXPECT_EQ(200u, a.firstVertex);
+    EXPECT_EQ(1000u - 250u, ranges.getVertices().getFreeSize());
+    EXPECT_EQ(1000u - 500u, ranges.getIndices().getFreeSize());
+    EXPECT_EQ(650u, ranges.getVertices().getLargestFreeRange());
+
+    ranges.free(&meshB);
+    ranges.free(&meshA);
+    EXPECT_EQ(1000u, ranges.getVertices().getLargestFreeRange());
+    EXPECT_EQ(1000u, ranges.getIndices().getLargestFreeRange());
+}
+
+TEST(GeometryPoolRanges, UpdateToSmallerVertexCount)
+{
+    GeometryPoolRanges ranges;
+    ranges.getVertices().grow(1000);
+    ranges.getIndices().grow(1000);
+    int meshA, meshB;
+    GeometryPoolRanges::Range a, b;
+    ASSERT_TRUE(ranges.allocate(&meshA, 100, 300, a));
+    ASSERT_TRUE(ranges.allocate(&meshB, 100, 300, b));
+
+    a = update(ranges, &meshA, 40, 120);
+    EXPECT_EQ(0u, a.firstVertex);
+    EXPECT_EQ(1000u - 140u, ranges.getVertices().getFreeSize());
+    EXPECT_EQ(1000u - 420u, ranges.getIndices().getFreeSize());
+
+    // the whole range of A is released (nothing leaks)
+    ranges.free(&meshA);
+    ranges.free(&meshB);
+    EXPECT_EQ(1000u, ranges.getVertices().getLargestFreeRange());
+    EXPECT_EQ(1000u, ranges.getIndices().getLargestFreeRange());
+}
+
+TEST(GeometryPoolRanges, FailedAllocationAllocatesNothing)
+{
+    GeometryPoolRanges ranges;
+    ranges.getVertices().grow(100);
+    ranges.getIndices().grow(10);
+    int mesh;
+    GeometryPoolRanges::Range range;
+    EXPECT_FALSE(ranges.allocate(&mesh, 50, 20, range));
+    EXPECT_FALSE(ranges.contains(&mesh));
+    EXPECT_EQ(100u, ranges.getVertices().getFreeSize());
+    ranges.getIndices().grow(20);
+    EXPECT_TRUE(ranges.allocate(&mesh, 50, 20, range));
+    EXPECT_TRUE(ranges.contains(&mesh));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "sre/impl/NormalMatrices.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+namespace {
+    std::vector<glm::mat4> createTransforms(size_t count, bool uniformScale){
+        std::vector<glm::mat4> transforms;
+        for (size_t i = 0; i < count; i++){
+            float f = (float)i;
+            glm::mat4 m = glm::translate(glm::mat4(1), glm::vec3(f, -f, 2*f));
+            m = glm::rotate(m, f * 0.1f, glm::normalize(glm::vec3(1, f, 2)));
+            if (uniformScale){
+                m = glm::scale(m, glm::vec3(1.0f + (i % 7)));
+            } else {
+                m = glm::scale(m, glm::vec3(1.0f + (i % 3), 2.0f, 0.5f + (i % 5)));
+            }
+            transforms.push_back(m);
+        }
+        return transforms;
+    }
+
+    void expectNear(const glm::mat3& expected, const glm::mat3& actual){
+        for (int c = 0; c < 3; c++){
+            for (int r = 0; r < 3; r++){
+                EXPECT_NEAR(expected[c][r], actual[c][r], 1e-4f * (1.0f + std::abs(expected[c][r])));
+            }
+        }
+    }
+}
+
+TEST(NormalMatrices, MatchesInverseTranspose)
+{
+    for (bool uniformScale : {true, false}){
+        auto transforms = createTransforms(150, uniformScale);
+        std::vector<glm::mat3> normalMatrices(transforms.size());
+        computeNormalMatrices(transforms.data(), sizeof(glm::mat4), normalMatrices.data(), transforms.size());
+        for (size_t i = 0; i < transforms.size(); i++){
+            expectNear(glm::transpose(glm::inverse(glm::mat3(transforms[i]))), normalMatrices[i]);
+        }
+    }
+}
+
+TEST(NormalMatrices, Strided)
+{
+    struct Obj {
+        int before;
+        glm::mat4 model;
+        int after;
+    };
+    auto transforms = createTransforms(70, false);
+    std::vector<Obj> objs;
+    for (auto& t : transforms){
+        objs.push_back({1, t, 2});
+    }
+    std::vector<glm::mat3> normalMatrices(objs.size());
+    computeNormalMatrices(&objs[0].model, sizeof(Obj), normalMatrices.data(), objs.size());
+    for (size_t i = 0; i < objs.size(); i++){
+        expectNear(glm::transpose(glm::inverse(glm::mat3(transforms[i]))), normalMatrices[i]);
+    }
+}
+
+TEST(NormalMatrices, SingularGivesZero)
+{
+    glm::mat4 singular = glm::scale(glm::mat4(1), glm::vec3(1, 0, 1));
+    glm::mat3 normalMatrix(1);
+    computeNormalMatrices(&singular, sizeof(glm::mat4), &normalMatrix, 1);
+    expectNear(glm::mat3(0), normalMatrix);
+}
+
+// Prints the cost per 10k draws of computing normal matrices one by one and batched.
+// Disabled by default (timings only); run using --gtest_also_run_disabled_tests --gtest_filter=*Benchmark
+TEST(NormalMatrices, DISABLED_Benchmark)
+{
+    const size_t count = 10000;
+    const int iterations = 50;
+    for (bool uniformScale : {true, false}){
+        auto transforms = createTransforms(count, uniformScale);
+        std::vector<glm::mat3> normalMatrices(count);
+
+        float checksum = 0;         // prevents the compiler from removing the loops
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < iterations; it++){
+            for (size_t i = 0; i < count; i++){
+                normalMatrices[i] = glm::transpose(glm::inverse(glm::mat3(transforms[i])));
+            }
+            checksum += normalMatrices[it][0][0];
+        }
+        auto mid = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < iterations; it++){
+            computeNormalMatrices(transforms.data(), sizeof(glm::mat4), normalMatrices.data(), count);
+            checksum += normalMatrices[it][0][0];
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        EXPECT_TRUE(std::isfinite(checksum));
+
+        double perDraw = std::chrono::duration<double, std::micro>(mid - start).count() / iterations;
+        double batched = std::chrono::duration<double, std::micro>(end - mid).count() / iterations;
+        std::cout << (uniformScale ? "uniform scale" : "non-uniform scale") << " per 10k draws: "
+                  << perDraw << " us (per draw) " << batched << " us (batched)" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
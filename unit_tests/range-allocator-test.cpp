@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "sre/impl/RangeAllocator.hpp"
+
+using namespace sre;
+
+TEST(RangeAllocator, FirstFit)
+{
+    RangeAllocator allocator(100);
+    EXPECT_EQ(0u, allocator.allocate(10));
+    EXPECT_EQ(10u, allocator.allocate(20));
+    EXPECT_EQ(30u, allocator.allocate(70));
+    EXPECT_EQ(RangeAllocator::invalid, allocator.allocate(1));
+    EXPECT_EQ(0u, allocator.getFreeSize());
+}
+
+TEST(RangeAllocator, FreedRangesAreMerged)
+{
+    RangeAllocator allocator(100);
+    size_t a = allocator.allocate(10);
+    size_t b = allocator.allocate(20);
+    size_t c = allocator.allocate(30);
+    allocator.allocate(40);
+    allocator.free(a, 10);
+    allocator.free(c, 30);
+    EXPECT_EQ(30u, allocator.getLargestFreeRange());
+    EXPECT_EQ(RangeAllocator::invalid, allocator.allocate(60));
+    allocator.free(b, 20);      // merged with both neighbours
+    EXPECT_EQ(60u, allocator.getLargestFreeRange());
+    EXPECT_EQ(0u, allocator.allocate(60));
+}
+
+TEST(RangeAllocator, Grow)
+{
+    RangeAllocator allocator(10);
+    allocator.allocate(5);
+    EXPECT_EQ(RangeAllocator::invalid, allocator.allocate(10));
+    allocator.grow(20);         // the free tail [5;10) is merged with the new space
+    EXPECT_EQ(15u, allocator.getLargestFreeRange());
+    EXPECT_EQ(5u, allocator.allocate(10));
+    EXPECT_EQ(20u, allocator.getCapacity());
+}
+
+TEST(RangeAllocator, EmptyRanges)
+{
+    RangeAllocator allocator;
+    EXPECT_EQ(0u, allocator.allocate(0));
+    allocator.free(0, 0);
+    EXPECT_EQ(RangeAllocator::invalid, allocator.allocate(1));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
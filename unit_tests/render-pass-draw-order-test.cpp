@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <SDL.h>
+#include "sre/Renderer.hpp"
+#include "sre/RenderList.hpp"
+#include "sre/Framebuffer.hpp"
+#include "sre/Texture.hpp"
+#include "sre/Material.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/Shader.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+namespace {
+    constexpr int size = 64;
+
+    // Hidden window with an OpenGL 3.3 core context. Skips the test when no context can be created (such as on a
+    // build server without a display)
+    class RenderPassDrawOrder : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            if (SDL_Init(SDL_INIT_VIDEO) != 0){
+                GTEST_SKIP() << "SDL video not available: " << SDL_GetError();
+            }
+            SDL_GL_SetAttribute(SDL_GL_FRAMEBUFFER_SRGB_CAPABLE, 1);
+            SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+            SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+            window = SDL_CreateWindow("RenderPassDrawOrder", 0, 0, size, size, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+            if (window == nullptr){
+                GTEST_SKIP() << "Cannot create window: " << SDL_GetError();
+            }
+            // the Renderer exits if the context cannot be created
+            SDL_GLContext context = SDL_GL_CreateContext(window);
+            if (context == nullptr){
+                GTEST_SKIP() << "OpenGL 3.3 not available: " << SDL_GetError();
+            }
+            SDL_GL_DeleteContext(context);
+            renderer = new Renderer(window, false);
+        }
+
+        void TearDown() override {
+            delete renderer;
+            if (window != nullptr){
+                SDL_DestroyWindow(window);
+            }
+            SDL_Quit();
+        }
+
+        std::shared_ptr<Material> createMaterial(Color color){
+            auto shader = Shader::create()
+                    .withSourceResource("unlit_vert.glsl", ShaderType::Vertex)
+                    .withSourceResource("unlit_frag.glsl", ShaderType::Fragment)
+                    .withDepthTest(false)
+                    .withName("Unlit no depth test")
+                    .build();
+            auto material = shader->createMaterial();
+            material->setColor(color);
+            return material;
+        }
+
+        static void expectColor(RenderPass& renderPass, int x, int y, Color expected){
+            auto pixel = renderPass.readPixels(x, y)[0];
+            EXPECT_NEAR(expected.r, pixel.r, 0.01f) << "at " << x << "," << y;
+            EXPECT_NEAR(expected.g, pixel.g, 0.01f) << "at " << x << "," << y;
+            EXPECT_NEAR(expected.b, pixel.b, 0.01f) << "at " << x << "," << y;
+        }
+
+        SDL_Window* window = nullptr;
+        Renderer* renderer = nullptr;
+    };
+}
+
+// With SortMode::None the draw calls of the renderpass are rendered first, then the draw calls of the recorders and
+// last the draw calls of the render lists (regardless of the order the draw calls were submitted). The quads are
+// drawn without depth test, each smaller than the previous, so each stays visible only when drawn in that order
+TEST_F(RenderPassDrawOrder, RenderPassThenRecordersThenRenderLists)
+{
+    Color red{1, 0, 0, 1};
+    Color green{0, 1, 0, 1};
+    Color blue{0, 0, 1, 1};
+    auto texture = Texture::create().withRGBAData(nullptr, size, size).withGenerateMipmaps(false).build();
+    auto framebuffer = Framebuffer::create().withColorTexture(texture).build();
+    auto quad = Mesh::create().withQuad().build();
+    auto renderPassMaterial = createMaterial(red);
+    auto recorderMaterial = createMaterial(green);
+    auto renderListMaterial = createMaterial(blue);
+
+    auto renderList = RenderList::create();
+    renderList->draw(quad, glm::scale(glm::mat4(1), glm::vec3(0.25f)), renderListMaterial);
+
+    auto renderPass = RenderPass::create()
+            .withFramebuffer(framebuffer)
+            .withClearColor(true, {0, 0, 0, 1})
+            .withSortMode(SortMode::None)
+            .withGUI(false)
+            .build();
+    renderPass.draw(renderList);
+    auto recorder = renderPass.createRecorder();
+    recorder->draw(quad, glm::scale(glm::mat4(1), glm::vec3(0.5f)), recorderMaterial);
+    renderPass.draw(quad, glm::mat4(1), renderPassMaterial);
+    renderPass.finish();
+
+    expectColor(renderPass, 2, 2, red);                // only covered by the quad of the renderpass
+    expectColor(renderPass, 44, 44, green);            // covered by the quads of the renderpass and the recorder
+    expectColor(renderPass, size/2, size/2, blue);     // covered by all quads
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
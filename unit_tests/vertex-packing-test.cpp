@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "sre/impl/VertexPacking.hpp"
+
+using namespace sre;
+
+TEST(VertexPacking, Sizes)
+{
+    EXPECT_EQ(12, vertexAttributeBytes(VertexAttributeFormat::Float, 3));
+    EXPECT_EQ(8, vertexAttributeBytes(VertexAttributeFormat::Half, 3));     // padded to 4 bytes
+    EXPECT_EQ(4, vertexAttributeBytes(VertexAttributeFormat::Half, 2));
+    EXPECT_EQ(4, vertexAttributeBytes(VertexAttributeFormat::UNorm8, 3));
+    EXPECT_EQ(8, vertexAttributeBytes(VertexAttributeFormat::SNorm16, 4));
+    EXPECT_EQ(4, vertexAttributeBytes(VertexAttributeFormat::SNorm10_10_10_2, 3));
+}
+
+TEST(VertexPacking, Half)
+{
+    EXPECT_EQ(0x0000, floatToHalf(0.0f));
+    EXPECT_EQ(0x8000, floatToHalf(-0.0f));
+    EXPECT_EQ(0x3c00, floatToHalf(1.0f));
+    EXPECT_EQ(0xc000, floatToHalf(-2.0f));
+    EXPECT_EQ(0x3555, floatToHalf(1.0f/3.0f));
+    EXPECT_EQ(0x7bff, floatToHalf(65504.0f));                               // largest half
+    EXPECT_EQ(0x7c00, floatToHalf(100000.0f));                              // overflow gives infinity
+    EXPECT_EQ(0x0001, floatToHalf(5.9604645e-8f));                          // smallest subnormal
+    EXPECT_EQ(0x0000, floatToHalf(1e-10f));
+}
+
+TEST(VertexPacking, Normalized)
+{
+    float values[4] = {1.0f, -1.0f, 0.5f, 2.0f};
+    int8_t snorm8[4];
+    packVertexAttribute(VertexAttributeFormat::SNorm8, values, 4, snorm8);
+    EXPECT_EQ(127, snorm8[0]);
+    EXPECT_EQ(-127, snorm8[1]);
+    EXPECT_EQ(64, snorm8[2]);
+    EXPECT_EQ(127, snorm8[3]);                                              // clamped
+
+    uint16_t unorm16[4];
+    packVertexAttribute(VertexAttributeFormat::UNorm16, values, 4, unorm16);
+    EXPECT_EQ(65535, unorm16[0]);
+    EXPECT_EQ(0, unorm16[1]);
+    EXPECT_EQ(32768, unorm16[2]);
+    EXPECT_EQ(65535, unorm16[3]);
+}
+
+TEST(VertexPacking, Packed10_10_10_2)
+{
+    float normal[3] = {1.0f, -1.0f, 0.0f};
+    uint32_t packed;
+    packVertexAttribute(VertexAttributeFormat::SNorm10_10_10_2, normal, 3, &packed);
+    EXPECT_EQ(511u, packed & 0x3ff);
+    EXPECT_EQ(0x201u, (packed >> 10) & 0x3ff);                              // -511 in 10 bit two's complement
+    EXPECT_EQ(0u, (packed >> 20) & 0x3ff);
+    EXPECT_EQ(0u, packed >> 30);
+
+    float color[4] = {1.0f, 0.0f, 0.5f, 1.0f};
+    packVertexAttribute(VertexAttributeFormat::UNorm10_10_10_2, color, 4, &packed);
+    EXPECT_EQ(1023u, packed & 0x3ff);
+    EXPECT_EQ(0u, (packed >> 10) & 0x3ff);
+    EXPECT_EQ(512u, (packed >> 20) & 0x3ff);
+    EXPECT_EQ(3u, packed >> 30);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}